@@ -0,0 +1,127 @@
+#include "allocationcounter.h"
+
+#ifdef ECOCAR_COUNT_ALLOCATIONS
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Constant-initialised, so touching it never allocates itself
+thread_local std::uint64_t threadAllocations = 0;
+
+void *allocate(std::size_t size)
+{
+    ++threadAllocations;
+    return std::malloc(size ? size : 1);
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    ++threadAllocations;
+    std::size_t align = std::max(std::size_t(alignment), sizeof(void *));
+    void *pointer = nullptr;
+    return posix_memalign(&pointer, align, size ? size : 1) == 0 ? pointer : nullptr;
+}
+
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    if (void *pointer = allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void *pointer = allocateAligned(size, alignment)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+bool allocations::counting()
+{
+    return true;
+}
+
+std::uint64_t allocations::thisThread()
+{
+    return threadAllocations;
+}
+
+#else
+
+bool allocations::counting()
+{
+    return false;
+}
+
+std::uint64_t allocations::thisThread()
+{
+    return 0;
+}
+
+#endif
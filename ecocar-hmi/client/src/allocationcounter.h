@@ -0,0 +1,20 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// Heap allocations counted by a replacement global operator new, built in
+// with the ECOCAR_COUNT_ALLOCATIONS CMake option. Counts are per thread,
+// so the ingest and GUI threads can each be checked for allocations on
+// their hot paths; without the option nothing is replaced and every count
+// stays 0.
+namespace allocations {
+
+bool counting();
+
+// Allocations made by the calling thread so far
+std::uint64_t thisThread();
+
+} // namespace allocations
+
+#endif // ALLOCATIONCOUNTER_H
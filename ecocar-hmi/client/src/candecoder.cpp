@@ -0,0 +1,126 @@
+#include "candecoder.h"
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+using MessageDecoder = CanDecoder::Result (*)(const int *slots, const std::uint8_t *data,
+                                              int length, std::int64_t timestamp,
+                                              SignalTable &table);
+
+template<std::size_t M>
+using Message = std::tuple_element_t<M, candbc::Messages>;
+
+void stageValue(SignalTable &table, int index, double value, std::int64_t timestamp,
+                bool valid = true)
+{
+    if (index < 0) {
+        return;
+    }
+    SignalSample &sample = table.stage(index);
+    sample.value = value;
+    sample.timestamp = timestamp;
+    sample.valid = valid;
+    sample.stale = false;
+}
+
+template<typename Msg, std::size_t I>
+void decodeSignal(const int *slots, const std::uint8_t *data, int length,
+                  std::int64_t timestamp, SignalTable &table)
+{
+    using Signal = std::tuple_element_t<I, typename Msg::Signals>;
+    if constexpr (Signal::validates < 0) {
+        if (length < Signal::bytes) {
+            return;
+        }
+        bool valid = true;
+        if constexpr (Signal::validity >= 0) {
+            // Senders that omit the validity flag are trusted
+            using Flag = std::tuple_element_t<Signal::validity, typename Msg::Signals>;
+            valid = length < Flag::bytes || Flag::bits(data) != 0;
+        }
+        stageValue(table, slots[I], canValue<Signal>(data), timestamp, valid);
+    }
+}
+
+template<typename Msg, std::size_t... I>
+CanDecoder::Result decodeMessage(const int *slots, const std::uint8_t *data, int length,
+                                 std::int64_t timestamp, SignalTable &table,
+                                 std::index_sequence<I...>)
+{
+    if (length < Msg::minLength) {
+        return CanDecoder::Malformed;
+    }
+    (decodeSignal<Msg, I>(slots + Msg::firstSignal, data, length, timestamp, table), ...);
+    return CanDecoder::Decoded;
+}
+
+template<typename Msg>
+CanDecoder::Result decodeMessage(const int *slots, const std::uint8_t *data, int length,
+                                 std::int64_t timestamp, SignalTable &table)
+{
+    constexpr std::size_t count = std::tuple_size_v<typename Msg::Signals>;
+    return decodeMessage<Msg>(slots, data, length, timestamp, table,
+                              std::make_index_sequence<count>());
+}
+
+// Indexed by candbc::hashSlot(); empty slots have no decoder
+struct DispatchEntry {
+    std::uint32_t id = 0;
+    MessageDecoder decoder = nullptr;
+};
+
+template<std::size_t... M>
+constexpr std::array<DispatchEntry, candbc::HASH_SIZE> makeDispatch(std::index_sequence<M...>)
+{
+    std::array<DispatchEntry, candbc::HASH_SIZE> table{};
+    ((table[candbc::hashSlot(Message<M>::id)] = {Message<M>::id,
+                                                  &decodeMessage<Message<M>>}), ...);
+    return table;
+}
+
+constexpr bool hashIsPerfect()
+{
+    for (int i = 0; i < candbc::MESSAGE_COUNT; ++i) {
+        if (candbc::HASH_SLOTS[candbc::hashSlot(candbc::MESSAGE_IDS[i])] != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(hashIsPerfect(), "candbc.h is out of date: message IDs collide");
+
+constexpr std::array<DispatchEntry, candbc::HASH_SIZE> DISPATCH =
+        makeDispatch(std::make_index_sequence<candbc::MESSAGE_COUNT>());
+
+} // namespace
+
+CanDecoder::CanDecoder(const SignalSchema &schema)
+    : slots(candbc::SIGNAL_COUNT)
+{
+    // Signals the schema does not know, e.g. the direction, are decoded
+    // to nowhere; validity flags are never staged themselves
+    for (int i = 0; i < candbc::SIGNAL_COUNT; ++i) {
+        slots[i] = schema.indexOf(candbc::SIGNAL_KEYS[i]);
+    }
+}
+
+const std::vector<std::uint32_t> &CanDecoder::messageIds()
+{
+    static const std::vector<std::uint32_t> ids(std::begin(candbc::MESSAGE_IDS),
+                                                std::end(candbc::MESSAGE_IDS));
+    return ids;
+}
+
+CanDecoder::Result CanDecoder::decode(std::uint32_t id, const std::uint8_t *data, int length,
+                                      std::int64_t timestamp, SignalTable &table) const
+{
+    const DispatchEntry &entry = DISPATCH[candbc::hashSlot(id)];
+    if (entry.id != id || !entry.decoder) {
+        return Ignored;
+    }
+    return entry.decoder(slots.data(), data, length, timestamp, table);
+}
@@ -0,0 +1,41 @@
+#ifndef CANDECODER_H
+#define CANDECODER_H
+
+#include <cstdint>
+#include <vector>
+#include "candbc.h"
+#include "signaltable.h"
+
+// Decodes CAN frames straight into schema slots, with the layouts of
+// can/ecocar.dbc compiled in: tools/dbcgen.py turns each message into
+// CanSignal types (candbc.h, which also defines MessageID), so every field
+// is read with constant offsets, masks and scales, and the frame's ID is
+// dispatched through a perfect hash. The spec's message structs are
+//
+//     0x100 VEHICLE_SPEED    u16 km/h * 100, u8 direction, u8 valid
+//     0x200 BATTERY_VOLTAGE  u16 V * 100, u16 A * 100, u16 °C * 10, u8 SoC %
+//
+// and the DBC gives the other IDs one field each. Frames may stop after
+// any whole signal; the rest of the message is then left as it was.
+class CanDecoder {
+public:
+    enum Result {
+        Decoded,
+        Ignored,   // Not a message this client decodes
+        Malformed  // Known ID, but too short for its layout
+    };
+
+    explicit CanDecoder(const SignalSchema &schema);
+
+    // Every ID decode() understands, for kernel-side filtering
+    static const std::vector<std::uint32_t> &messageIds();
+
+    // Stages the signals carried by one frame; the caller commits
+    Result decode(std::uint32_t id, const std::uint8_t *data, int length,
+                  std::int64_t timestamp, SignalTable &table) const;
+
+private:
+    std::vector<int> slots;  // Schema slot per candbc::SIGNAL_KEYS entry, or -1
+};
+
+#endif // CANDECODER_H
@@ -0,0 +1,82 @@
+#ifndef CANSIGNAL_H
+#define CANSIGNAL_H
+
+#include <cstdint>
+
+// DBC @1 (Intel) and @0 (Motorola)
+enum class ByteOrder {
+    LittleEndian,
+    BigEndian
+};
+
+// Layout of one DBC signal, fixed at compile time, so extracting it
+// compiles to a load of the bytes it spans, a shift and a mask. `Start` is
+// the DBC start bit: the least significant bit of a little endian signal,
+// the most significant one of a big endian signal. The types themselves
+// are generated from the DBC by tools/dbcgen.py (candbc.h).
+template<int Start, int Length, ByteOrder Order, bool Signed>
+struct CanSignal {
+    static constexpr int start = Start;
+    static constexpr int bitLength = Length;
+    static constexpr ByteOrder order = Order;
+    static constexpr bool isSigned = Signed;
+
+    // Bytes the signal spans; frames shorter than `bytes` do not carry it
+    static constexpr int firstByte = Start / 8;
+    static constexpr int lastByte = Order == ByteOrder::LittleEndian
+            ? (Start + Length - 1) / 8
+            : (Start / 8 * 8 + 7 - Start % 8 + Length - 1) / 8;
+    static constexpr int bytes = lastByte + 1;
+
+    static_assert(Length > 0 && Length <= 64 && lastByte - firstByte < 8,
+                  "A signal must fit in one 64-bit word");
+
+    // Raw bits, right-aligned; reads data[firstByte] to data[lastByte]
+    static std::uint64_t bits(const std::uint8_t *data)
+    {
+        std::uint64_t word = 0;
+        if constexpr (Order == ByteOrder::LittleEndian) {
+            for (int i = lastByte; i >= firstByte; --i) {
+                word = word << 8 | data[i];
+            }
+            word >>= Start % 8;
+        } else {
+            for (int i = firstByte; i <= lastByte; ++i) {
+                word = word << 8 | data[i];
+            }
+            word >>= 7 - (Start / 8 * 8 + 7 - Start % 8 + Length - 1) % 8;
+        }
+        return word & MASK;
+    }
+
+    static std::int64_t raw(const std::uint8_t *data)
+    {
+        if constexpr (Signed) {
+            const std::uint64_t sign = std::uint64_t(1) << (Length - 1);
+            return std::int64_t((bits(data) ^ sign) - sign);
+        } else {
+            return std::int64_t(bits(data));
+        }
+    }
+
+private:
+    static constexpr std::uint64_t MASK = Length == 64 ? ~std::uint64_t(0)
+                                                       : (std::uint64_t(1) << (Length % 64)) - 1;
+};
+
+// Physical value of a generated signal type: raw * factor + offset, with
+// the multiply and add left out where they change nothing
+template<typename Signal>
+double canValue(const std::uint8_t *data)
+{
+    double value = double(Signal::raw(data));
+    if constexpr (Signal::factor != 1.0) {
+        value *= Signal::factor;
+    }
+    if constexpr (Signal::offset != 0.0) {
+        value += Signal::offset;
+    }
+    return value;
+}
+
+#endif // CANSIGNAL_H
@@ -0,0 +1,164 @@
+#include "cansocket.h"
+#include <cerrno>
+#include <cstring>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+CanSocket::CanSocket(const QString &interfaceName, QObject *parent)
+    : QObject(parent)
+    , interfaceName(interfaceName)
+    , fd(-1)
+    , notifier(nullptr)
+{
+    std::memset(messages, 0, sizeof(messages));
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        vectors[i].iov_base = &frames[i];
+        vectors[i].iov_len = sizeof(can_frame);
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+CanSocket::~CanSocket()
+{
+    close();
+}
+
+void CanSocket::setFilter(const std::vector<quint32> &ids)
+{
+    // Exact match on the ID with the extended and remote flags clear, so
+    // only standard data frames pass
+    filters.clear();
+    for (quint32 id : ids) {
+        can_filter filter;
+        filter.can_id = id & CAN_SFF_MASK;
+        filter.can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        filters.push_back(filter);
+    }
+}
+
+bool CanSocket::open()
+{
+    close();
+
+    QByteArray name = interfaceName.toLocal8Bit();
+    if (name.isEmpty() || name.size() >= IFNAMSIZ) {
+        m_errorString = QStringLiteral("Invalid CAN interface name \"%1\"").arg(interfaceName);
+        return false;
+    }
+
+    fd = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (fd < 0) {
+        fail("socket");
+        return false;
+    }
+
+    struct ifreq request;
+    std::memset(&request, 0, sizeof(request));
+    std::memcpy(request.ifr_name, name.constData(), size_t(name.size()));
+    if (::ioctl(fd, SIOCGIFINDEX, &request) < 0) {
+        fail("SIOCGIFINDEX");
+        return false;
+    }
+
+    if (filters.empty()) {
+        can_filter filter;
+        filter.can_id = 0;
+        filter.can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG;
+        filters.push_back(filter);
+    }
+    if (::setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+                     socklen_t(filters.size() * sizeof(can_filter))) < 0) {
+        fail("CAN_RAW_FILTER");
+        return false;
+    }
+
+    struct sockaddr_can address;
+    std::memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    address.can_ifindex = request.ifr_ifindex;
+    if (::bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0) {
+        fail("bind");
+        return false;
+    }
+
+    notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &CanSocket::handleActivated);
+    m_errorString.clear();
+    return true;
+}
+
+void CanSocket::close()
+{
+    if (notifier) {
+        // May be running inside the notifier's own activation
+        notifier->setEnabled(false);
+        notifier->deleteLater();
+        notifier = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool CanSocket::isOpen() const
+{
+    return fd >= 0;
+}
+
+QString CanSocket::errorString() const
+{
+    return m_errorString;
+}
+
+void CanSocket::fail(const char *operation)
+{
+    m_errorString = QStringLiteral("%1 on %2: %3")
+                        .arg(QLatin1String(operation), interfaceName,
+                             QString::fromLocal8Bit(std::strerror(errno)));
+    close();
+}
+
+void CanSocket::handleActivated()
+{
+    // Drain everything queued so one wakeup covers a burst of frames
+    for (;;) {
+        int received = ::recvmmsg(fd, messages, BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            fail("recvmmsg");  // ENETDOWN when the interface goes down
+            emit closed();
+            return;
+        }
+
+        // Compact away anything that is not a whole classic frame
+        int count = 0;
+        for (int i = 0; i < received; ++i) {
+            if (messages[i].msg_len != sizeof(can_frame)) {
+                continue;
+            }
+            if (count != i) {
+                frames[count] = frames[i];
+            }
+            frames[count].can_id &= CAN_SFF_MASK;
+            ++count;
+        }
+        if (count > 0) {
+            emit framesReceived(frames, count);
+            if (fd < 0) {
+                return;  // Receiver closed the socket
+            }
+        }
+        if (received < BATCH_SIZE) {
+            return;  // Queue drained; skip the EAGAIN round trip
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef CANSOCKET_H
+#define CANSOCKET_H
+
+#include <QtCore/QObject>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QString>
+#include <vector>
+#include <linux/can.h>
+#include <sys/socket.h>
+
+// Raw SocketCAN socket bound to one interface (can0, vcan0, ...), read
+// from the owning thread's event loop. Only classic 11-bit data frames are
+// passed on; the spec's message IDs are all standard IDs.
+//
+// Frames are pulled up to BATCH_SIZE per recvmmsg() call and handed over
+// as one batch, so a loaded bus costs one syscall and one emission per
+// batch rather than per frame.
+class CanSocket : public QObject {
+    Q_OBJECT
+
+public:
+    explicit CanSocket(const QString &interfaceName, QObject *parent = nullptr);
+    ~CanSocket();
+
+    // Only these IDs get past the kernel; call before open(). Empty
+    // passes every standard data frame.
+    void setFilter(const std::vector<quint32> &ids);
+
+    bool open();
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+signals:
+    // `frames` is only valid during the emission. IDs are plain 11-bit
+    // IDs; extended, remote and error frames never get this far.
+    void framesReceived(const can_frame *frames, int count);
+    // The interface went away or the socket failed; not emitted by close()
+    void closed();
+
+private:
+    static const int BATCH_SIZE = 64;
+
+    QString interfaceName;
+    std::vector<can_filter> filters;
+    int fd;
+    QSocketNotifier *notifier;
+    QString m_errorString;
+
+    // Reused by every read
+    can_frame frames[BATCH_SIZE];
+    iovec vectors[BATCH_SIZE];
+    mmsghdr messages[BATCH_SIZE];
+
+    void handleActivated();
+    void fail(const char *operation);
+};
+
+#endif // CANSOCKET_H
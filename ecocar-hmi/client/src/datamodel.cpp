@@ -1,46 +1,128 @@
 #include "datamodel.h"
-#include <QtCore/QJsonObject>
-#include <QtCore/QJsonValue>
+#include <QtCharts/QChart>
+#include <QtCharts/QXYSeries>
+#include <QtCore/QElapsedTimer>
+#include <QtGui/QScreen>
+#include <algorithm>
+#include "allocationcounter.h"
 
 DataModel::DataModel(QObject *parent)
+    : DataModel(NetworkManager::defaultServerUrl(), DEFAULT_HISTORY_SECONDS, 0.0, parent)
+{
+}
+
+DataModel::DataModel(const QUrl &serverUrl, int historySeconds, double batteryCapacityKwh,
+                     QObject *parent)
     : QObject(parent)
-    , updateTimer(new QTimer(this))
-    , network(new NetworkManager(this))
-    , m_vehicleSpeed(0.0)
-    , m_batteryVoltage(0.0)
-    , m_motorTemp(0.0)
+    , history(SignalSchema::vehicle().size(), std::size_t(qMax(historySeconds, 1)) * HISTORY_RATE_HZ)
+    , statsCursors(SignalSchema::vehicle().size(), 0)
+    , statisticsNs(0)
+    , statisticsPending(false)
+    , diagnosticsNs(0)
+    , ingestThread(new QThread(this))
+    , worker(new IngestWorker(serverUrl, batteryCapacityKwh, &scheduler, &history, this))
+    , registry(new SignalModel(SignalSchema::vehicle(), this))
+    , displayFilter(SignalSchema::vehicle())
+    , thresholds(SignalSchema::vehicle())
+    , alertSlot(-1)
+    , interpolator(SignalSchema::vehicle().size())
     , m_connected(false)
+    , dirtyFlags(0)
+    , flushing(false)
+    , speedSlot(SignalSchema::vehicle().indexOf("speed"))
+    , batteryVoltageSlot(SignalSchema::vehicle().indexOf("battery_voltage"))
+    , motorTempSlot(SignalSchema::vehicle().indexOf("motor_temp"))
+    , appliedSnapshots(0)
+    , publishedUpdates(0)
+    , applyNs(0)
+    , ingestAllocations(0)
+    , applyAllocations(0)
+    , allocationsPerUpdate(0.0)
+    , requestedNotifications(0)
+    , emittedNotifications(0)
+    , pendingPhotonNs(0)
+    , syncedPhotonNs(0)
 {
-    // Connect network signals
-    connect(network, &NetworkManager::dataReceived, 
-            this, &DataModel::handleDataReceived);
-    connect(network, &NetworkManager::systemStatusReceived,
-            this, &DataModel::handleStatusReceived);
-    connect(network, &NetworkManager::error,
-            this, &DataModel::handleNetworkError);
+    // Networking and decoding run on the ingest thread; this thread only
+    // picks up the state it publishes, once per frame
+    worker->moveToThread(ingestThread);
+    connect(ingestThread, &QThread::started,
+            worker, &IngestWorker::start);
+    connect(ingestThread, &QThread::finished,
+            worker, &QObject::deleteLater);
+    connect(worker, &IngestWorker::error,
+            this, &DataModel::handleNetworkError, Qt::QueuedConnection);
+    
+    for (int i = 0; i < SignalSchema::vehicle().size(); ++i) {
+        windowStats.emplace_back(new WindowStats(HISTORY_RATE_HZ));
+    }
+    statsScratch.reserve(history.at(0).capacity());
+    snapshot.changed.reserve(SignalSchema::vehicle().size());
     
-    // Set up update timer (100ms from spec)
-    updateTimer->setInterval(100);
-    connect(updateTimer, &QTimer::timeout,
-            this, &DataModel::updateData);
+    // The speed needle follows the frame rate rather than the poll rate
+    setInterpolation("speed", "interpolate");
     
     // Start updates
-    updateTimer->start();
+    ingestThread->setObjectName("ingest");
+    ingestThread->start();
+}
+
+DataModel::~DataModel()
+{
+    ingestThread->quit();
+    ingestThread->wait();
+}
+
+void DataModel::attachWindow(QQuickWindow *window)
+{
+    this->window = window;
+    
+    // Emitted on this thread right before the scene graph syncs, once per
+    // frame; beforeSynchronizing would run on the render thread
+    connect(window, &QQuickWindow::afterAnimating,
+            this, &DataModel::flushNotifications);
+    
+    QScreen *screen = window->screen();
+    if (screen && screen->refreshRate() > 0) {
+        scheduler.setFramePeriod(qint64(1e9 / screen->refreshRate()));
+    }
+
+    // Both arrive on the render thread: the sync runs while this thread is
+    // blocked, so anything applied before it is in the frame that follows
+    connect(window, &QQuickWindow::afterSynchronizing, this, [this]() {
+        qint64 pending = pendingPhotonNs.exchange(0, std::memory_order_acq_rel);
+        if (pending != 0) {
+            syncedPhotonNs = pending;
+        }
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        qint64 now = PollScheduler::now();
+        scheduler.frameSwapped(now);
+        if (syncedPhotonNs != 0) {
+            scheduler.recordPhotonLatency(now - syncedPhotonNs);
+            syncedPhotonNs = 0;
+        }
+    }, Qt::DirectConnection);
 }
 
 double DataModel::vehicleSpeed() const
 {
-    return m_vehicleSpeed;
+    return registry->at(speedSlot).value;
+}
+
+bool DataModel::isVehicleSpeedStale() const
+{
+    return registry->at(speedSlot).stale;
 }
 
 double DataModel::batteryVoltage() const
 {
-    return m_batteryVoltage;
+    return registry->at(batteryVoltageSlot).value;
 }
 
 double DataModel::motorTemp() const
 {
-    return m_motorTemp;
+    return registry->at(motorTempSlot).value;
 }
 
 bool DataModel::isConnected() const
@@ -48,56 +130,562 @@ bool DataModel::isConnected() const
     return m_connected;
 }
 
-void DataModel::updateData()
+SignalModel *DataModel::signalModel() const
+{
+    return registry;
+}
+
+bool DataModel::isStreaming() const
+{
+    return snapshot.streaming;
+}
+
+QVariantMap DataModel::requestStats() const
+{
+    const NetworkManager::RequestStats &stats = snapshot.requestStats;
+    return {
+        {"sent", stats.sent},
+        {"completed", stats.completed},
+        {"dropped", stats.dropped},
+        {"cancelled", stats.cancelled},
+        {"late", stats.late},
+        {"resyncs", stats.resyncs},
+    };
+}
+
+static QVariantMap formatStatsMap(const NetworkManager::FormatStats &format)
+{
+    double payloads = format.payloads > 0 ? double(format.payloads) : 1.0;
+    return {
+        {"payloads", format.payloads},
+        {"bytesPerUpdate", double(format.bytes) / payloads},
+        {"decodeUsPerUpdate", double(format.decodeNs) / payloads / 1000.0},
+    };
+}
+
+QVariantMap DataModel::decodeStats() const
+{
+    const NetworkManager::DecodeStats &stats = snapshot.decodeStats;
+    return {
+        {"json", formatStatsMap(stats.json)},
+        {"cbor", formatStatsMap(stats.cbor)},
+    };
+}
+
+QVariantMap DataModel::ingestStats() const
+{
+    double applied = appliedSnapshots > 0 ? double(appliedSnapshots) : 1.0;
+    QVariantMap stats = {
+        {"published", publishedUpdates},
+        {"applied", appliedSnapshots},
+        {"guiUsPerApply", double(applyNs) / applied / 1000.0},
+        {"notifications", emittedNotifications},
+        {"coalescedNotifications", requestedNotifications - emittedNotifications},
+        {"suppressed", quint64(displayFilter.suppressed())},
+    };
+    if (allocations::counting()) {
+        stats.insert("ingestAllocations", ingestAllocations);
+        stats.insert("applyAllocations", applyAllocations);
+        stats.insert("allocationsPerUpdate", allocationsPerUpdate);
+    }
+    return stats;
+}
+
+static QVariantMap latencyStatsMap(const PollScheduler::LatencyStats &stats)
+{
+    double frames = stats.frames > 0 ? double(stats.frames) : 1.0;
+    return {
+        {"frames", stats.frames},
+        {"avgMs", double(stats.totalNs) / frames / 1e6},
+        {"maxMs", double(stats.maxNs) / 1e6},
+    };
+}
+
+QVariantMap DataModel::latencyStats() const
+{
+    bool active = scheduler.mode() == PollScheduler::Active;
+    PollScheduler::FrameStats frameTimes = scheduler.frameTimes();
+    double frames = frameTimes.frames > 0 ? double(frameTimes.frames) : 1.0;
+    return {
+        {"mode", active ? "active" : "idle"},
+        {"framePeriodMs", double(scheduler.framePeriod()) / 1e6},
+        {"frameTime", QVariantMap{
+            {"frames", frameTimes.frames},
+            {"missed", frameTimes.missed},
+            {"avgMs", double(frameTimes.totalNs) / frames / 1e6},
+            {"maxMs", double(frameTimes.maxNs) / 1e6},
+        }},
+        {"idle", latencyStatsMap(scheduler.latency(PollScheduler::Idle))},
+        {"active", latencyStatsMap(scheduler.latency(PollScheduler::Active))},
+    };
+}
+
+QString DataModel::alertKey() const
+{
+    return alertSlot < 0 ? QString() : QString::fromLatin1(SignalSchema::vehicle().at(alertSlot).key);
+}
+
+int DataModel::alertLevel() const
+{
+    return alertSlot < 0 ? 0 : int(thresholds.level(alertSlot));
+}
+
+bool DataModel::setDeadband(const QString &key, const QString &mode, double amount)
+{
+    int slot = registry->indexOf(key);
+    if (slot < 0) {
+        return false;
+    }
+    
+    Deadband deadband;
+    deadband.amount = amount;
+    if (mode == QLatin1String("none")) {
+        deadband.mode = Deadband::None;
+    } else if (mode == QLatin1String("absolute")) {
+        deadband.mode = Deadband::Absolute;
+    } else if (mode == QLatin1String("relative")) {
+        deadband.mode = Deadband::Relative;
+    } else if (mode == QLatin1String("precision")) {
+        deadband.mode = Deadband::Precision;
+    } else {
+        return false;
+    }
+    displayFilter.setDeadband(slot, deadband);
+    return true;
+}
+
+bool DataModel::setInterpolation(const QString &key, const QString &mode)
+{
+    int slot = registry->indexOf(key);
+    if (slot < 0) {
+        return false;
+    }
+    
+    Interpolator::Mode interpolation;
+    if (mode == QLatin1String("off")) {
+        interpolation = Interpolator::Off;
+    } else if (mode == QLatin1String("interpolate")) {
+        interpolation = Interpolator::Interpolate;
+    } else if (mode == QLatin1String("extrapolate")) {
+        interpolation = Interpolator::Extrapolate;
+    } else {
+        return false;
+    }
+    
+    interpolator.setMode(slot, interpolation);
+    auto it = std::find(interpolatedSlots.begin(), interpolatedSlots.end(), slot);
+    if (interpolation == Interpolator::Off && it != interpolatedSlots.end()) {
+        interpolatedSlots.erase(it);
+    } else if (interpolation != Interpolator::Off && it == interpolatedSlots.end()) {
+        interpolatedSlots.push_back(slot);
+    }
+    return true;
+}
+
+int DataModel::displayLatency(const QString &key) const
+{
+    int slot = registry->indexOf(key);
+    return slot < 0 ? 0 : int(interpolator.latency(slot));
+}
+
+QVariantMap DataModel::thresholdRule(const QString &key) const
+{
+    int slot = registry->indexOf(key);
+    if (slot < 0 || !thresholds.rule(slot).enabled) {
+        return QVariantMap();
+    }
+    const ThresholdRule &rule = thresholds.rule(slot);
+    return {
+        {"warning", rule.warning},
+        {"error", rule.error},
+        {"hysteresis", rule.hysteresis},
+        {"below", rule.below},
+    };
+}
+
+void DataModel::resetTrip()
+{
+    QMetaObject::invokeMethod(worker, &IngestWorker::resetTrip, Qt::QueuedConnection);
+    for (const std::unique_ptr<WindowStats> &stats : windowStats) {
+        stats->resetTrip();
+    }
+    emit statisticsChanged();
+}
+
+QVariantMap DataModel::statistics(const QString &key, const QString &window) const
 {
-    network->fetchLatestData();
-    network->fetchSystemStatus();
+    int slot = registry->indexOf(key);
+    if (slot < 0) {
+        return QVariantMap();
+    }
+    
+    WindowStats::Window span;
+    if (window == QLatin1String("1s")) {
+        span = WindowStats::Second;
+    } else if (window == QLatin1String("10s")) {
+        span = WindowStats::TenSeconds;
+    } else if (window == QLatin1String("1m")) {
+        span = WindowStats::Minute;
+    } else if (window == QLatin1String("trip")) {
+        span = WindowStats::Trip;
+    } else {
+        return QVariantMap();
+    }
+    
+    StatsSummary summary = windowStats[slot]->summary(span);
+    return {
+        {"count", quint64(summary.count)},
+        {"min", summary.min},
+        {"max", summary.max},
+        {"mean", summary.mean},
+        {"stddev", summary.stddev},
+        {"p50", summary.p50},
+        {"p95", summary.p95},
+    };
+}
+
+void DataModel::updateSeries(QAbstractSeries *series, const QString &key, double windowSeconds,
+                             const QString &method)
+{
+    QXYSeries *xySeries = qobject_cast<QXYSeries *>(series);
+    if (!xySeries) {
+        return;
+    }
+    
+    auto it = seriesStates.find(series);
+    if (it == seriesStates.end()) {
+        int slot = registry->indexOf(key);
+        if (slot < 0) {
+            return;
+        }
+        // A full ring is the most one read can return
+        SeriesState state;
+        state.slot = slot;
+        state.incoming.reserve(history.at(slot).capacity());
+        state.tail.reserve(4);
+        it = seriesStates.insert(series, state);
+        connect(series, &QObject::destroyed, this, [this, series]() {
+            seriesStates.remove(series);
+        });
+    }
+    SeriesState &state = *it;
+    const HistoryRing &ring = history.at(state.slot);
+    
+    // One bucket per pixel column; on a resize or a new window the buckets
+    // are rebuilt from whatever the ring still holds
+    int columns = MIN_PLOT_COLUMNS;
+    if (series->chart()) {
+        columns = qMax(columns, int(series->chart()->plotArea().width()));
+    }
+    qint64 windowMs = qMax<qint64>(1, qint64(windowSeconds * 1000.0));
+    qint64 bucketWidth = (windowMs + columns - 1) / columns;
+    Downsampler::Method downsampling = method == QLatin1String("lttb") ? Downsampler::Lttb
+                                                                       : Downsampler::MinMax;
+    bool rebuild = state.downsampler.bucketWidth() != bucketWidth
+                   || state.downsampler.method() != downsampling;
+    if (rebuild) {
+        std::size_t bucketSamples = std::size_t(bucketWidth * HISTORY_RATE_HZ / 1000) * 2 + 2;
+        state.downsampler.reset(downsampling, bucketWidth, std::size_t(columns) + 2, bucketSamples);
+        state.cursor = 0;
+        for (QList<QPointF> &points : state.points) {
+            points.reserve(qsizetype(columns) * 2 + 8);
+        }
+    }
+    
+    state.incoming.clear();
+    state.cursor = ring.read(state.cursor, state.incoming);
+    if (state.incoming.empty()) {
+        if (!rebuild) {
+            return;  // Nothing new; x is relative to the newest sample
+        }
+    } else {
+        state.newest = state.incoming.back().timestamp;
+    }
+    
+    qint64 cutoff = state.newest - windowMs;
+    for (const HistoryPoint &point : state.incoming) {
+        if (point.timestamp >= cutoff - bucketWidth) {
+            state.downsampler.add(point);
+        }
+    }
+    state.downsampler.trim(cutoff);
+    state.tail.clear();
+    state.downsampler.tail(state.tail);
+    
+    QList<QPointF> &points = state.points[state.current];
+    state.current ^= 1;
+    points.clear();
+    for (std::size_t i = 0; i < state.downsampler.size(); ++i) {
+        const HistoryPoint &point = state.downsampler.at(i);
+        points.append(QPointF(double(point.timestamp - state.newest) / 1000.0, point.value));
+    }
+    for (const HistoryPoint &point : state.tail) {
+        points.append(QPointF(double(point.timestamp - state.newest) / 1000.0, point.value));
+    }
+    xySeries->replace(points);
 }
 
 void DataModel::handleNetworkError(const QString &error)
 {
     emit this->error(error);
-    m_connected = false;
-    emit connectionStatusChanged();
+    if (m_connected) {
+        m_connected = false;
+        markDirty(ConnectedDirty, 1);
+    }
+}
+
+void DataModel::customEvent(QEvent *event)
+{
+    if (event->type() == SnapshotReadyEvent::SnapshotReady) {
+        handleSnapshotReady();
+    }
 }
 
-void DataModel::handleDataReceived(const QJsonObject &data)
+void DataModel::handleSnapshotReady()
 {
-    QJsonObject messages = data["messages"].toObject();
+    // The state is taken at the start of the next frame, so every value
+    // in a frame comes from the same published state
+    if (window) {
+        window->requestUpdate();
+    } else {
+        flushNotifications();
+    }
+}
+
+void DataModel::applySnapshot()
+{
+    QElapsedTimer timer;
+    timer.start();
+    quint64 allocationsBefore = allocations::thisThread();
+    
+    bool wasStreaming = snapshot.streaming;
+    if (!worker->takeSnapshot(snapshot)) {
+        return;
+    }
+    
+    // Keep the oldest arrival until a frame picks it up
+    if (!snapshot.changed.empty() && snapshot.receivedNs != 0) {
+        qint64 expected = 0;
+        pendingPhotonNs.compare_exchange_strong(expected, snapshot.receivedNs,
+                                                std::memory_order_acq_rel);
+    }
     
-    // Update vehicle speed
-    if (messages.contains("speed")) {
-        double newSpeed = messages["speed"].toObject()["value"].toDouble();
-        if (m_vehicleSpeed != newSpeed) {
-            m_vehicleSpeed = newSpeed;
-            emit vehicleSpeedChanged();
+    // Only the slots changed since the last snapshot, and of those only
+    // the ones that look different on screen. Nothing is emitted here:
+    // bindings see the changes once, at the next frame
+    qint64 arrivalMs = (snapshot.receivedNs != 0 ? snapshot.receivedNs
+                                                 : PollScheduler::now()) / 1000000;
+    for (int index : snapshot.changed) {
+        const SignalSample &sample = snapshot.samples[index];
+        thresholds.evaluate(index, sample);
+        if (interpolator.mode(index) != Interpolator::Off && window) {
+            // The value itself is set by renderInterpolated(), which runs
+            // right after this in the same frame
+            const SignalSample &shown = registry->at(index);
+            if (sample.valid) {
+                interpolator.add(index, sample.timestamp, sample.value, arrivalMs);
+                if (shown.valid && shown.stale == sample.stale) {
+                    continue;
+                }
+            } else {
+                interpolator.clear(index);
+            }
         }
+        if (!displayFilter.accept(index, sample, thresholds.level(index))
+                || !registry->update(index, sample, thresholds.level(index))) {
+            continue;
+        }
+        
+        quint32 flag = slotFlag(index);
+        markDirty(flag, flag ? 2 : 1);  // Property and model row
+    }
+    if (!thresholds.transitions().empty()) {
+        markDirty(ThresholdDirty, thresholds.transitions().size() + 1);
     }
     
-    // Update battery voltage
-    if (messages.contains("battery_voltage")) {
-        double newVoltage = messages["battery_voltage"].toObject()["value"].toDouble();
-        if (m_batteryVoltage != newVoltage) {
-            m_batteryVoltage = newVoltage;
-            emit batteryVoltageChanged();
+    if (snapshot.statusChanged) {
+        bool newConnected = snapshot.status.connected;
+        if (m_connected != newConnected) {
+            m_connected = newConnected;
+            markDirty(ConnectedDirty, 1);
         }
     }
     
-    // Update motor temperature
-    if (messages.contains("motor_temp")) {
-        double newTemp = messages["motor_temp"].toObject()["value"].toDouble();
-        if (m_motorTemp != newTemp) {
-            m_motorTemp = newTemp;
-            emit motorTempChanged();
+    if (snapshot.streaming != wasStreaming) {
+        markDirty(StreamingDirty, 1);
+    }
+    if (snapshot.published > 0) {
+        markDirty(HistoryDirty, 1);
+    }
+    
+    // Everything the ingest thread allocated since the previous snapshot
+    // plus what applying this one did, spread over the updates in it
+    quint64 applied = allocations::thisThread() - allocationsBefore;
+    applyAllocations += applied;
+    if (snapshot.published > 0) {
+        quint64 ingested = snapshot.allocations - ingestAllocations;
+        ingestAllocations = snapshot.allocations;
+        allocationsPerUpdate = double(ingested + applied) / double(snapshot.published);
+    }
+    
+    ++appliedSnapshots;
+    publishedUpdates += snapshot.published;
+    applyNs += timer.nsecsElapsed();
+    
+    // The counters move with every snapshot, but rebuilding their four maps
+    // every frame is not worth it for a diagnostics display
+    qint64 now = PollScheduler::now();
+    if (now - diagnosticsNs >= qint64(STATISTICS_INTERVAL_MS) * 1000000) {
+        diagnosticsNs = now;
+        markDirty(StatsDirty, 4);
+    }
+}
+
+void DataModel::markDirty(quint32 flags, quint64 notifications)
+{
+    dirtyFlags |= flags;
+    requestedNotifications += notifications;
+    if (flushing) {
+        return;
+    }
+    
+    // Without a window there is no frame to wait for
+    if (window) {
+        window->requestUpdate();
+    } else {
+        flushNotifications();
+    }
+}
+
+quint32 DataModel::slotFlag(int index) const
+{
+    if (index == speedSlot) {
+        return SpeedDirty;
+    } else if (index == batteryVoltageSlot) {
+        return BatteryVoltageDirty;
+    } else if (index == motorTempSlot) {
+        return MotorTempDirty;
+    }
+    return 0;
+}
+
+void DataModel::renderInterpolated()
+{
+    if (!window || interpolatedSlots.empty()) {
+        return;
+    }
+    
+    // Values for this frame; the deadband still applies, so a signal
+    // that has settled stops causing updates
+    qint64 nowMs = PollScheduler::now() / 1000000;
+    bool moving = false;
+    for (int slot : interpolatedSlots) {
+        double value;
+        SignalSample sample = registry->at(slot);
+        if (!sample.valid || !interpolator.valueAt(slot, nowMs, value)) {
+            continue;
+        }
+        moving = moving || interpolator.isMoving(slot, nowMs);
+        sample.value = value;
+        if (displayFilter.accept(slot, sample, thresholds.level(slot))
+                && registry->update(slot, sample, thresholds.level(slot))) {
+            quint32 flag = slotFlag(slot);
+            dirtyFlags |= flag;
+            requestedNotifications += flag ? 2 : 1;
         }
     }
+    
+    // Keep frames coming until every interpolated value has caught up
+    if (moving) {
+        window->requestUpdate();
+    }
 }
 
-void DataModel::handleStatusReceived(const QJsonObject &status)
+void DataModel::updateStatistics()
 {
-    bool newConnected = status["connected"].toBool();
-    if (m_connected != newConnected) {
-        m_connected = newConnected;
+    // Every sample since the last frame, straight from the history rings
+    for (int slot = 0; slot < history.size(); ++slot) {
+        statsScratch.clear();
+        statsCursors[slot] = history.at(slot).read(statsCursors[slot], statsScratch);
+        for (const HistoryPoint &point : statsScratch) {
+            windowStats[slot]->add(point.timestamp, point.value);
+        }
+        statisticsPending = statisticsPending || !statsScratch.empty();
+    }
+    
+    // Windows only move when they take a sample
+    qint64 now = PollScheduler::now();
+    if (statisticsPending && now - statisticsNs >= qint64(STATISTICS_INTERVAL_MS) * 1000000) {
+        statisticsNs = now;
+        statisticsPending = false;
+        emit statisticsChanged();
+    }
+}
+
+void DataModel::flushNotifications()
+{
+    flushing = true;
+    applySnapshot();
+    renderInterpolated();
+    flushing = false;
+    
+    quint32 flags = dirtyFlags;
+    dirtyFlags = 0;
+    
+    quint64 emitted = quint64(registry->flush());
+    if (flags & SpeedDirty) {
+        emit vehicleSpeedChanged();
+        ++emitted;
+    }
+    if (flags & BatteryVoltageDirty) {
+        emit batteryVoltageChanged();
+        ++emitted;
+    }
+    if (flags & MotorTempDirty) {
+        emit motorTempChanged();
+        ++emitted;
+    }
+    if (flags & ConnectedDirty) {
         emit connectionStatusChanged();
+        ++emitted;
+    }
+    if (flags & StreamingDirty) {
+        emit streamingChanged();
+        ++emitted;
+    }
+    if (flags & HistoryDirty) {
+        updateStatistics();
+        emit historyUpdated();
+        ++emitted;
+    }
+    if (flags & ThresholdDirty) {
+        static const QString names[] = {QStringLiteral("normal"), QStringLiteral("warning"),
+                                        QStringLiteral("error")};
+        for (const ThresholdEngine::Transition &transition : thresholds.transitions()) {
+            const QString key = QString::fromLatin1(SignalSchema::vehicle().at(transition.slot).key);
+            emit thresholdChanged(key, transition.to, transition.from, transition.value);
+            if (transition.to > transition.from) {
+                emit thresholdExceeded(key, transition.value, names[transition.to]);
+            }
+            ++emitted;
+        }
+        thresholds.clearTransitions();
+        
+        // Transitions are rare; the top alert is simply re-announced
+        alertSlot = thresholds.topSlot();
+        emit alertChanged();
+        ++emitted;
+    }
+    
+    // Counted before the stats go out so ingestStats is current
+    if (flags & StatsDirty) {
+        emitted += 4;
+    }
+    emittedNotifications += emitted;
+    if (flags & StatsDirty) {
+        emit requestStatsChanged();
+        emit decodeStatsChanged();
+        emit latencyStatsChanged();
+        emit ingestStatsChanged();
     }
 }
\ No newline at end of file
@@ -1,50 +1,228 @@
 #ifndef DATAMODEL_H
 #define DATAMODEL_H
 
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/QObject>
-#include <QtCore/QTimer>
-#include <QtCore/QJsonObject>
-#include "networkmanager.h"
+#include <QtCore/QPointF>
+#include <QtCore/QPointer>
+#include <QtCore/QThread>
+#include <QtCore/QVariantMap>
+#include <QtCharts/QAbstractSeries>
+#include <QtQuick/QQuickWindow>
+#include <atomic>
+#include "displayfilter.h"
+#include "downsampler.h"
+#include "ingestworker.h"
+#include "interpolator.h"
+#include "pollscheduler.h"
+#include "signalhistory.h"
+#include "signalmodel.h"
+#include "thresholdengine.h"
+#include "windowstats.h"
 
 class DataModel : public QObject {
     Q_OBJECT
     
     // Properties
     Q_PROPERTY(double vehicleSpeed READ vehicleSpeed NOTIFY vehicleSpeedChanged)
+    Q_PROPERTY(bool vehicleSpeedStale READ isVehicleSpeedStale NOTIFY vehicleSpeedChanged)
     Q_PROPERTY(double batteryVoltage READ batteryVoltage NOTIFY batteryVoltageChanged)
     Q_PROPERTY(double motorTemp READ motorTemp NOTIFY motorTempChanged)
     Q_PROPERTY(bool connected READ isConnected NOTIFY connectionStatusChanged)
+    // Every signal in the schema, one row each (roles: key, unit, value,
+    // timestamp, valid, stale, level)
+    Q_PROPERTY(SignalModel *signalModel READ signalModel CONSTANT)
+    Q_PROPERTY(bool streaming READ isStreaming NOTIFY streamingChanged)
+    Q_PROPERTY(QVariantMap requestStats READ requestStats NOTIFY requestStatsChanged)
+    Q_PROPERTY(QVariantMap decodeStats READ decodeStats NOTIFY decodeStatsChanged)
+    Q_PROPERTY(QVariantMap ingestStats READ ingestStats NOTIFY ingestStatsChanged)
+    Q_PROPERTY(QVariantMap latencyStats READ latencyStats NOTIFY latencyStatsChanged)
+    // The most severe, then highest priority, signal out of its normal
+    // range ("" if none) and its level: 0 normal, 1 warning, 2 error
+    Q_PROPERTY(QString alertKey READ alertKey NOTIFY alertChanged)
+    Q_PROPERTY(int alertLevel READ alertLevel NOTIFY alertChanged)
     
 public:
+    // History kept per signal, at up to HISTORY_RATE_HZ samples a second
+    static const int DEFAULT_HISTORY_SECONDS = 600;
+    static const int HISTORY_RATE_HZ = 100;
+    
     explicit DataModel(QObject *parent = nullptr);
+    // A battery capacity of zero (unknown) leaves range invalid
+    DataModel(const QUrl &serverUrl, int historySeconds, double batteryCapacityKwh,
+              QObject *parent = nullptr);
+    ~DataModel() override;
+    
+    // Follows the window's frame clock: polls are timed against it, the
+    // ingest state is picked up and change notifications are flushed once
+    // per frame, and data-to-photon latency is measured at its swaps
+    void attachWindow(QQuickWindow *window);
     
     // Getters
     double vehicleSpeed() const;
+    bool isVehicleSpeedStale() const;
     double batteryVoltage() const;
     double motorTemp() const;
     bool isConnected() const;
+    SignalModel *signalModel() const;
+    bool isStreaming() const;
+    QVariantMap requestStats() const;
+    QVariantMap decodeStats() const;
+    QVariantMap ingestStats() const;
+    QVariantMap latencyStats() const;
+    QString alertKey() const;
+    int alertLevel() const;
+    
+    // How far a signal must move before the display follows: `mode` is
+    // "absolute" or "relative" (by `amount`), "precision" (`amount`
+    // decimals) or "none". Returns false for an unknown key or mode.
+    Q_INVOKABLE bool setDeadband(const QString &key, const QString &mode, double amount);
+    
+    // How a signal's value is brought to the frame rate: "off" shows each
+    // sample as it arrives, "interpolate" and "extrapolate" recompute it
+    // every frame (see Interpolator). Returns false for an unknown key or
+    // mode.
+    Q_INVOKABLE bool setInterpolation(const QString &key, const QString &mode);
+    // How far the shown value of a signal trails its source, in ms
+    Q_INVOKABLE int displayLatency(const QString &key) const;
+    // Threshold rule of a signal: warning, error, hysteresis and below, or
+    // an empty map if it has none
+    Q_INVOKABLE QVariantMap thresholdRule(const QString &key) const;
+    
+    // Starts the trip's energy and distance (and what derives from them)
+    // and the trip statistics from zero
+    Q_INVOKABLE void resetTrip();
+    
+    // Rolling statistics of a signal over `window` "1s", "10s", "1m" or
+    // "trip": count, min, max, mean, stddev, p50 and p95. Kept up to date
+    // sample by sample, so reading them costs nothing; re-read them on
+    // statisticsChanged().
+    Q_INVOKABLE QVariantMap statistics(const QString &key, const QString &window) const;
+    
+    // Fills `series` (an XYSeries) with the last `windowSeconds` of a
+    // signal's history, x in seconds relative to its newest sample,
+    // downsampled to one bucket per pixel column of the plot area with
+    // `method` "minmax" (default) or "lttb". Only new samples are read;
+    // call it on historyUpdated().
+    Q_INVOKABLE void updateSeries(QAbstractSeries *series, const QString &key,
+                                  double windowSeconds,
+                                  const QString &method = QStringLiteral("minmax"));
     
 signals:
     void vehicleSpeedChanged();
     void batteryVoltageChanged();
     void motorTempChanged();
     void connectionStatusChanged();
+    void streamingChanged();
+    void requestStatsChanged();
+    void decodeStatsChanged();
+    void ingestStatsChanged();
+    void latencyStatsChanged();
+    void historyUpdated();
+    void alertChanged();
+    void statisticsChanged();
+    // Threshold level transitions, evaluated natively for every signal;
+    // thresholdExceeded() is the rising half ("warning" or "error")
+    void thresholdChanged(const QString &key, int level, int previousLevel, double value);
+    void thresholdExceeded(const QString &key, double value, const QString &threshold);
     void error(const QString &message);
     
 private slots:
-    void updateData();
     void handleNetworkError(const QString &error);
-    void handleDataReceived(const QJsonObject &data);
-    void handleStatusReceived(const QJsonObject &status);
+    void flushNotifications();
+    
+protected:
+    void customEvent(QEvent *event) override;
     
 private:
-    QTimer *updateTimer;
-    NetworkManager *network;
+    // NOTIFY signals owed at the next flush
+    enum DirtyFlag : quint32 {
+        SpeedDirty = 1u << 0,
+        BatteryVoltageDirty = 1u << 1,
+        MotorTempDirty = 1u << 2,
+        ConnectedDirty = 1u << 3,
+        StreamingDirty = 1u << 4,
+        StatsDirty = 1u << 5,
+        HistoryDirty = 1u << 6,
+        ThresholdDirty = 1u << 7
+    };
+    
+    // Chart series being fed from history through a downsampler, with two
+    // point buffers used in turn, so the one handed to the series last
+    // time is never modified (and detached) in place
+    struct SeriesState {
+        int slot = -1;
+        std::uint64_t cursor = 0;
+        qint64 newest = 0;
+        std::vector<HistoryPoint> incoming;
+        std::vector<HistoryPoint> tail;
+        Downsampler downsampler;
+        QList<QPointF> points[2];
+        int current = 0;
+    };
+    
+    // Plot width assumed until the chart has been laid out
+    static const int MIN_PLOT_COLUMNS = 64;
+    // statisticsChanged() and the diagnostics stats go out at most this
+    // often
+    static const int STATISTICS_INTERVAL_MS = 500;
+    
+    PollScheduler scheduler;
+    SignalHistory history;
+    QHash<QAbstractSeries *, SeriesState> seriesStates;
+    std::vector<std::unique_ptr<WindowStats>> windowStats;  // Fed from history
+    std::vector<std::uint64_t> statsCursors;
+    std::vector<HistoryPoint> statsScratch;
+    qint64 statisticsNs;
+    bool statisticsPending;  // A window took a sample since the last statisticsChanged()
+    qint64 diagnosticsNs;    // requestStats and the rest last went out
+    QPointer<QQuickWindow> window;
+    QThread *ingestThread;
+    IngestWorker *worker;  // Lives on ingestThread
+    VehicleSnapshot snapshot;
+    SignalModel *registry;
+    DisplayFilter displayFilter;  // Decides what reaches the registry
+    ThresholdEngine thresholds;   // Evaluated on raw samples
+    int alertSlot;
+    Interpolator interpolator;
+    std::vector<int> interpolatedSlots;
     
-    double m_vehicleSpeed;
-    double m_batteryVoltage;
-    double m_motorTemp;
     bool m_connected;
+    quint32 dirtyFlags;
+    bool flushing;  // Changes made now go out with the flush in progress
+    
+    // Slots of the properties above in SignalSchema::vehicle()
+    int speedSlot;
+    int batteryVoltageSlot;
+    int motorTempSlot;
+    
+    // GUI-thread cost of applying snapshots. Only the threaded side is
+    // measured; decoding itself is timed per format in decodeStats.
+    quint64 appliedSnapshots;
+    quint64 publishedUpdates;
+    qint64 applyNs;
+    
+    // Heap allocations on the ingest path, if counted (allocationcounter.h)
+    quint64 ingestAllocations;
+    quint64 applyAllocations;
+    double allocationsPerUpdate;  // Over the last applied snapshot
+    
+    // Notifications the changes asked for, and how many were emitted
+    quint64 requestedNotifications;
+    quint64 emittedNotifications;
+    
+    // Arrival time of applied data not yet synchronised to the scene graph,
+    // and of the data in the frame being rendered (render thread only)
+    std::atomic<qint64> pendingPhotonNs;
+    qint64 syncedPhotonNs;
+    
+    void handleSnapshotReady();
+    void applySnapshot();
+    void markDirty(quint32 flags, quint64 notifications);
+    quint32 slotFlag(int index) const;
+    void renderInterpolated();
+    void updateStatistics();
 };
 
 #endif // DATAMODEL_H
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "derivedsignals.h"
+
+namespace {
+
+const std::int64_t MAX_GAP_MS = 5000;        // Longer gaps are not integrated
+const double MIN_DENOMINATOR = 1.0;          // Ratios below it are unknown, e.g. under 1 Wh
+const double MS_PER_HOUR = 3600000.0;
+
+struct NodeDef {
+    const char *output;
+    int kind;
+    const char *inputs[2];
+    double scale;
+};
+
+// DerivedSignals::Kind by value; any order, sorted at construction
+const NodeDef NODE_DEFS[] = {
+    {"power", 0, {"battery_voltage", "battery_current"}, 0.001},        // kW
+    {"energy_used", 1, {"power", nullptr}, 1000.0},                     // kW h to Wh
+    {"trip_distance", 1, {"speed", nullptr}, 1.0},                      // km/h h to km
+    {"efficiency", 2, {"trip_distance", "energy_used"}, 1000.0},        // km per kWh
+    {"range", 3, {"battery_soc", "efficiency"}, 0.01},                  // Times capacity, km
+};
+
+} // namespace
+
+DerivedSignals::DerivedSignals(const SignalSchema &schema, double batteryCapacityKwh)
+    : readerStart(schema.size() + 1, 0)
+    , derived(schema.size(), 0)
+    , values(schema.size())
+{
+    std::vector<Node> unsorted;
+    for (const NodeDef &def : NODE_DEFS) {
+        Node node;
+        node.kind = Kind(def.kind);
+        node.output = schema.indexOf(def.output);
+        node.inputCount = 0;
+        node.scale = def.scale;
+        bool resolved = node.output >= 0;
+        if (node.kind == Remaining) {
+            // Without a known capacity the slot stays derived but invalid
+            node.scale *= batteryCapacityKwh;
+            if (resolved && batteryCapacityKwh <= 0.0) {
+                derived[node.output] = 1;
+                resolved = false;
+            }
+        }
+        for (const char *input : def.inputs) {
+            if (input) {
+                int slot = schema.indexOf(input);
+                resolved = resolved && slot >= 0;
+                node.inputs[node.inputCount++] = slot;
+            }
+        }
+        if (resolved) {
+            derived[node.output] = 1;
+            unsorted.push_back(node);
+        }
+    }
+
+    // Kahn's algorithm: a node is ready once no unplaced node outputs one
+    // of its inputs. A cycle leaves its nodes out.
+    std::vector<char> placed(unsorted.size(), 0);
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (std::size_t i = 0; i < unsorted.size(); ++i) {
+            if (placed[i]) {
+                continue;
+            }
+            bool ready = true;
+            for (int k = 0; k < unsorted[i].inputCount && ready; ++k) {
+                for (std::size_t j = 0; j < unsorted.size(); ++j) {
+                    if (!placed[j] && unsorted[j].output == unsorted[i].inputs[k]) {
+                        ready = false;
+                        break;
+                    }
+                }
+            }
+            if (ready) {
+                placed[i] = 1;
+                nodes.push_back(unsorted[i]);
+                progress = true;
+            }
+        }
+    }
+    dirty.assign(nodes.size(), 0);
+
+    // Readers of each slot, flattened
+    for (const Node &node : nodes) {
+        for (int k = 0; k < node.inputCount; ++k) {
+            ++readerStart[node.inputs[k] + 1];
+        }
+    }
+    for (std::size_t slot = 0; slot + 1 < readerStart.size(); ++slot) {
+        readerStart[slot + 1] += readerStart[slot];
+    }
+    readers.resize(readerStart.back());
+    std::vector<int> fill(readerStart.begin(), readerStart.end() - 1);
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        for (int k = 0; k < nodes[i].inputCount; ++k) {
+            readers[fill[nodes[i].inputs[k]]++] = int(i);
+        }
+    }
+}
+
+void DerivedSignals::update(const SignalTable &table, std::vector<int> &updated)
+{
+    bool any = false;
+    for (int slot : table.updated()) {
+        if (readerStart[slot] != readerStart[slot + 1]) {
+            values[slot] = table.at(slot);
+            markReaders(slot);
+            any = true;
+        }
+    }
+    if (!any) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        if (!dirty[i]) {
+            continue;
+        }
+        dirty[i] = 0;
+        Node &node = nodes[i];
+        SignalSample &out = values[node.output];
+        SignalSample next = out;
+        compute(node, next);
+        if (next.value == out.value && next.valid == out.valid && next.stale == out.stale
+                && next.timestamp == out.timestamp) {
+            continue;
+        }
+        out = next;
+        updated.push_back(node.output);
+        markReaders(node.output);
+    }
+}
+
+bool DerivedSignals::isDerived(int slot) const
+{
+    return derived[slot];
+}
+
+const SignalSample &DerivedSignals::at(int slot) const
+{
+    return values[slot];
+}
+
+void DerivedSignals::resetTrip()
+{
+    for (Node &node : nodes) {
+        node.sum = 0.0;
+        node.hasLast = false;
+    }
+}
+
+void DerivedSignals::markReaders(int slot)
+{
+    for (int i = readerStart[slot]; i < readerStart[slot + 1]; ++i) {
+        dirty[readers[i]] = 1;
+    }
+}
+
+void DerivedSignals::compute(Node &node, SignalSample &out) const
+{
+    const SignalSample &a = values[node.inputs[0]];
+    const SignalSample &b = values[node.inputs[node.inputCount - 1]];
+    out.valid = a.valid && b.valid;
+    out.stale = a.stale || b.stale;
+    out.timestamp = a.timestamp > b.timestamp ? a.timestamp : b.timestamp;
+    if (!out.valid) {
+        return;
+    }
+
+    switch (node.kind) {
+    case Product:
+        out.value = a.value * b.value * node.scale;
+        break;
+    case Integral: {
+        // Trapezoids between successive samples; gaps are skipped
+        std::int64_t gap = a.timestamp - node.lastTime;
+        if (node.hasLast && gap > 0 && gap <= MAX_GAP_MS) {
+            node.sum += (node.lastInput + a.value) * 0.5 * double(gap) / MS_PER_HOUR;
+        }
+        if (!node.hasLast || gap > 0) {
+            node.lastInput = a.value;
+            node.lastTime = a.timestamp;
+            node.hasLast = true;
+        }
+        out.value = node.sum * node.scale;
+        break;
+    }
+    case Ratio:
+        out.valid = b.value >= MIN_DENOMINATOR;
+        out.value = out.valid ? a.value / b.value * node.scale : 0.0;
+        break;
+    case Remaining:
+        out.value = a.value * node.scale * b.value;
+        break;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef DERIVEDSIGNALS_H
+#define DERIVEDSIGNALS_H
+
+#include <cstdint>
+#include <vector>
+#include "signaltable.h"
+
+// Signals computed from others (power, energy, efficiency, range), kept in
+// schema slots of their own so they flow through history, staleness,
+// thresholds and the model like any decoded signal. The nodes form a
+// dependency graph sorted once at construction; update() marks the nodes
+// reading a new sample and recomputes only those, in topological order,
+// which marks their own readers in turn. Nothing allocates after
+// construction.
+class DerivedSignals {
+public:
+    // Range needs the usable pack energy; at zero it is never computed
+    DerivedSignals(const SignalSchema &schema, double batteryCapacityKwh);
+
+    // Takes the slots written by the table's last commit and appends every
+    // derived slot that got a new sample to `updated`
+    void update(const SignalTable &table, std::vector<int> &updated);
+
+    bool isDerived(int slot) const;
+    const SignalSample &at(int slot) const;
+
+    // Starts energy and distance from zero again
+    void resetTrip();
+
+private:
+    static const int MAX_INPUTS = 2;
+
+    enum Kind {
+        Product,    // in0 * in1 * scale
+        Integral,   // Running sum of in0 over time in hours, times scale
+        Ratio,      // in0 / in1 * scale
+        Remaining   // in0 * scale * in1, e.g. state of charge to range
+    };
+
+    struct Node {
+        Kind kind;
+        int output;
+        int inputs[MAX_INPUTS];
+        int inputCount;
+        double scale;
+
+        // Integral state
+        double sum = 0.0;
+        double lastInput = 0.0;
+        std::int64_t lastTime = 0;
+        bool hasLast = false;
+    };
+
+    void markReaders(int slot);
+    void compute(Node &node, SignalSample &out) const;
+
+    std::vector<Node> nodes;            // Topological order
+    std::vector<int> readerStart;       // Per slot, into readers; size + 1 entries
+    std::vector<int> readers;           // Nodes reading each slot
+    std::vector<char> derived;          // Per slot
+    std::vector<char> dirty;            // Per node
+    std::vector<SignalSample> values;   // Latest of every slot involved
+};
+
+#endif // DERIVEDSIGNALS_H
@@ -0,0 +1,70 @@
+#include "displayfilter.h"
+#include <cmath>
+
+namespace {
+
+// Matches the two decimals VehicleStatusView shows
+const int DEFAULT_DECIMALS = 2;
+
+} // namespace
+
+DisplayFilter::DisplayFilter(const SignalSchema &schema)
+    : entries(schema.size())
+    , suppressedCount(0)
+{
+    for (Entry &entry : entries) {
+        entry.deadband.mode = Deadband::Precision;
+        entry.deadband.amount = DEFAULT_DECIMALS;
+    }
+}
+
+void DisplayFilter::setDeadband(int slot, const Deadband &deadband)
+{
+    entries[slot].deadband = deadband;
+}
+
+const Deadband &DisplayFilter::deadband(int slot) const
+{
+    return entries[slot].deadband;
+}
+
+bool DisplayFilter::accept(int slot, const SignalSample &sample, int level)
+{
+    Entry &entry = entries[slot];
+    bool show = !entry.hasShown
+                || sample.valid != entry.shown.valid
+                || sample.stale != entry.shown.stale
+                || level != entry.level
+                || (sample.valid && outsideDeadband(entry.deadband, entry.shown.value, sample.value));
+    if (!show) {
+        ++suppressedCount;
+        return false;
+    }
+
+    entry.shown = sample;
+    entry.hasShown = true;
+    entry.level = level;
+    return true;
+}
+
+unsigned long long DisplayFilter::suppressed() const
+{
+    return suppressedCount;
+}
+
+bool DisplayFilter::outsideDeadband(const Deadband &deadband, double shown, double value)
+{
+    switch (deadband.mode) {
+    case Deadband::None:
+        return value != shown;
+    case Deadband::Absolute:
+        return std::fabs(value - shown) >= deadband.amount;
+    case Deadband::Relative:
+        return std::fabs(value - shown) >= deadband.amount * std::fabs(shown);
+    case Deadband::Precision: {
+        double scale = std::pow(10.0, deadband.amount);
+        return std::llround(value * scale) != std::llround(shown * scale);
+    }
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef DISPLAYFILTER_H
+#define DISPLAYFILTER_H
+
+#include <vector>
+#include "signaltable.h"
+
+// How far a value must move from the one on screen before it is shown
+struct Deadband {
+    enum Mode {
+        None,       // Any change
+        Absolute,   // By at least `amount`, in the signal's unit
+        Relative,   // By at least `amount` times the shown value
+        Precision   // Enough to change it when shown with `amount` decimals
+    };
+
+    Mode mode = None;
+    double amount = 0.0;
+};
+
+// Sits between ingest and the display: decides, per schema slot, whether
+// a new sample differs visibly from the one last shown. Changes of
+// validity, staleness or threshold level (ThresholdEngine) always pass. Comparing against
+// the shown sample rather than the previous one means slow drift is
+// still shown once it adds up.
+class DisplayFilter {
+public:
+    explicit DisplayFilter(const SignalSchema &schema);
+
+    void setDeadband(int slot, const Deadband &deadband);
+    const Deadband &deadband(int slot) const;
+
+    // True if the sample should be shown; it then becomes the shown one
+    bool accept(int slot, const SignalSample &sample, int level);
+
+    // Samples held back by a deadband so far
+    unsigned long long suppressed() const;
+
+private:
+    struct Entry {
+        Deadband deadband;
+        SignalSample shown;
+        bool hasShown = false;
+        int level = 0;
+    };
+
+    static bool outsideDeadband(const Deadband &deadband, double shown, double value);
+
+    std::vector<Entry> entries;
+    unsigned long long suppressedCount;
+};
+
+#endif // DISPLAYFILTER_H
@@ -0,0 +1,208 @@
+#include "downsampler.h"
+#include <cmath>
+
+Downsampler::Downsampler()
+    : m_method(MinMax)
+    , width(0)  // Until reset()
+    , openBucket(0)
+    , maxPoints(0)
+    , outputStart(0)
+    , hasOpen(false)
+    , low{0, 0.0}
+    , high{0, 0.0}
+    , anchored(false)
+    , anchor{0, 0.0}
+    , sumTime(0.0)
+    , sumValue(0.0)
+{
+}
+
+void Downsampler::reset(Method method, std::int64_t bucketWidth, std::size_t maxBuckets,
+                        std::size_t bucketSamples)
+{
+    m_method = method;
+    width = bucketWidth > 0 ? bucketWidth : 1;
+    maxPoints = maxBuckets * 2 + 2;
+
+    // Twice what a window holds, so the front only needs compacting now
+    // and then
+    output.clear();
+    output.reserve(maxPoints * 2);
+    outputStart = 0;
+
+    hasOpen = false;
+    anchored = false;
+    pending.clear();
+    current.clear();
+    if (method == Lttb) {
+        pending.reserve(bucketSamples);
+        current.reserve(bucketSamples);
+    }
+    sumTime = 0.0;
+    sumValue = 0.0;
+}
+
+Downsampler::Method Downsampler::method() const
+{
+    return m_method;
+}
+
+std::int64_t Downsampler::bucketWidth() const
+{
+    return width;
+}
+
+void Downsampler::add(const HistoryPoint &point)
+{
+    std::int64_t bucket = point.timestamp / width;
+
+    if (m_method == MinMax) {
+        if (hasOpen && bucket != openBucket) {
+            closeMinMax();
+        }
+        if (!hasOpen) {
+            hasOpen = true;
+            openBucket = bucket;
+            low = point;
+            high = point;
+            return;
+        }
+        if (point.value < low.value) {
+            low = point;
+        }
+        if (point.value > high.value) {
+            high = point;
+        }
+        return;
+    }
+
+    // LTTB always keeps the first sample
+    if (!anchored) {
+        anchored = true;
+        anchor = point;
+        emitPoint(point);
+        return;
+    }
+    if (!current.empty() && bucket != openBucket) {
+        closeLttb();
+    }
+    if (current.empty()) {
+        openBucket = bucket;
+    }
+    current.push_back(point);
+    sumTime += double(point.timestamp - anchor.timestamp);
+    sumValue += point.value;
+}
+
+void Downsampler::trim(std::int64_t cutoff)
+{
+    while (outputStart < output.size() && output[outputStart].timestamp < cutoff) {
+        ++outputStart;
+    }
+}
+
+std::size_t Downsampler::size() const
+{
+    return output.size() - outputStart;
+}
+
+const HistoryPoint &Downsampler::at(std::size_t index) const
+{
+    return output[outputStart + index];
+}
+
+void Downsampler::tail(std::vector<HistoryPoint> &out) const
+{
+    if (m_method == MinMax) {
+        if (hasOpen) {
+            bool lowFirst = low.timestamp <= high.timestamp;
+            out.push_back(lowFirst ? low : high);
+            if (low.timestamp != high.timestamp) {
+                out.push_back(lowFirst ? high : low);
+            }
+        }
+        return;
+    }
+
+    // The pending bucket picked against what the open one holds so far,
+    // then the newest sample so the line reaches the right edge
+    const HistoryPoint *last = nullptr;
+    if (!pending.empty()) {
+        const HistoryPoint &next = current.empty() ? pending.back() : average();
+        const HistoryPoint &picked = largestTriangle(pending, anchor, next);
+        out.push_back(picked);
+        last = &picked;
+    }
+    const HistoryPoint *newest = !current.empty() ? &current.back()
+                               : !pending.empty() ? &pending.back() : nullptr;
+    if (newest && (!last || newest->timestamp != last->timestamp)) {
+        out.push_back(*newest);
+    }
+}
+
+void Downsampler::emitPoint(const HistoryPoint &point)
+{
+    if (output.size() - outputStart >= maxPoints) {
+        ++outputStart;  // Not trimmed; never hold more than one window
+    }
+    if (output.size() == output.capacity() && outputStart > 0) {
+        output.erase(output.begin(), output.begin() + std::ptrdiff_t(outputStart));
+        outputStart = 0;
+    }
+    output.push_back(point);
+}
+
+void Downsampler::closeMinMax()
+{
+    bool lowFirst = low.timestamp <= high.timestamp;
+    emitPoint(lowFirst ? low : high);
+    if (low.timestamp != high.timestamp) {
+        emitPoint(lowFirst ? high : low);
+    }
+    hasOpen = false;
+}
+
+void Downsampler::closeLttb()
+{
+    if (!pending.empty()) {
+        const HistoryPoint &picked = largestTriangle(pending, anchor, average());
+        emitPoint(picked);
+        anchor = picked;
+    }
+    pending.swap(current);
+    current.clear();
+
+    // The running sums are relative to the anchor, which may have moved
+    sumTime = 0.0;
+    sumValue = 0.0;
+}
+
+HistoryPoint Downsampler::average() const
+{
+    double count = double(current.size());
+    HistoryPoint point;
+    point.timestamp = anchor.timestamp + std::int64_t(std::llround(sumTime / count));
+    point.value = sumValue / count;
+    return point;
+}
+
+const HistoryPoint &Downsampler::largestTriangle(const std::vector<HistoryPoint> &points,
+                                                 const HistoryPoint &previous,
+                                                 const HistoryPoint &next)
+{
+    // Twice the triangle's area; times are taken relative to `previous`
+    // to keep the products small
+    const double nextTime = double(next.timestamp - previous.timestamp);
+    const double nextValue = next.value - previous.value;
+    std::size_t best = 0;
+    double bestArea = -1.0;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        double time = double(points[i].timestamp - previous.timestamp);
+        double area = std::fabs(time * nextValue - nextTime * (points[i].value - previous.value));
+        if (area > bestArea) {
+            bestArea = area;
+            best = i;
+        }
+    }
+    return points[best];
+}
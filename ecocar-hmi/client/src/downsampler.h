@@ -0,0 +1,71 @@
+#ifndef DOWNSAMPLER_H
+#define DOWNSAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "signalhistory.h"
+
+// Reduces a stream of samples to a few points per time bucket for drawing,
+// with one bucket per pixel column of the chart. Buckets are aligned to
+// absolute time, so a closed bucket never changes again and each add()
+// only touches the newest ones. at() covers the closed buckets; tail()
+// gives provisional points for those still open.
+class Downsampler {
+public:
+    enum Method {
+        MinMax,  // Lowest and highest sample of each bucket; keeps every spike
+        Lttb     // Largest-Triangle-Three-Buckets; one sample per bucket
+    };
+
+    Downsampler();
+
+    // Starts over. Storage is sized here for `maxBuckets` buckets of about
+    // `bucketSamples` samples each and reused from then on.
+    void reset(Method method, std::int64_t bucketWidth, std::size_t maxBuckets,
+               std::size_t bucketSamples);
+
+    Method method() const;
+    std::int64_t bucketWidth() const;
+
+    // Samples must arrive in timestamp order
+    void add(const HistoryPoint &point);
+    // Forgets output older than `cutoff`
+    void trim(std::int64_t cutoff);
+
+    std::size_t size() const;
+    const HistoryPoint &at(std::size_t index) const;
+    void tail(std::vector<HistoryPoint> &out) const;
+
+private:
+    void emitPoint(const HistoryPoint &point);
+    void closeMinMax();
+    void closeLttb();
+    HistoryPoint average() const;
+    static const HistoryPoint &largestTriangle(const std::vector<HistoryPoint> &points,
+                                               const HistoryPoint &previous,
+                                               const HistoryPoint &next);
+
+    Method m_method;
+    std::int64_t width;
+    std::int64_t openBucket;
+    std::size_t maxPoints;
+    std::vector<HistoryPoint> output;
+    std::size_t outputStart;
+
+    // MinMax: extremes of the open bucket
+    bool hasOpen;
+    HistoryPoint low;
+    HistoryPoint high;
+
+    // LTTB: a bucket's pick depends on the previous pick and the average
+    // of the next bucket, so the last two buckets are kept in full
+    bool anchored;
+    HistoryPoint anchor;
+    std::vector<HistoryPoint> pending;
+    std::vector<HistoryPoint> current;
+    double sumTime;
+    double sumValue;
+};
+
+#endif // DOWNSAMPLER_H
@@ -0,0 +1,363 @@
+#include "ingestworker.h"
+#include <QtCore/QCoreApplication>
+#include <cmath>
+#include "allocationcounter.h"
+#include "thresholdengine.h"
+
+namespace {
+
+const double MOVING_SPEED_KMH = 1.0;
+const qint64 IDLE_AFTER_NS = 2000000000;  // Stay active this long after the last trigger
+
+// Within this fraction of a warning threshold counts as near it
+const double NEAR_FRACTION = 0.1;
+
+// Storage for the SnapshotReadyEvent in flight
+alignas(SnapshotReadyEvent) unsigned char eventSlot[sizeof(SnapshotReadyEvent)];
+std::atomic<bool> eventSlotUsed(false);
+
+} // namespace
+
+SnapshotReadyEvent::SnapshotReadyEvent()
+    : QEvent(SnapshotReady)
+{
+}
+
+void *SnapshotReadyEvent::operator new(std::size_t size)
+{
+    // The next one can be posted while the last is still being delivered
+    if (size <= sizeof(eventSlot) && !eventSlotUsed.exchange(true, std::memory_order_acquire)) {
+        return eventSlot;
+    }
+    return ::operator new(size);
+}
+
+void SnapshotReadyEvent::operator delete(void *pointer)
+{
+    if (pointer == eventSlot) {
+        eventSlotUsed.store(false, std::memory_order_release);
+    } else {
+        ::operator delete(pointer);
+    }
+}
+
+IngestWorker::IngestWorker(const QUrl &serverUrl, double batteryCapacityKwh,
+                           PollScheduler *scheduler, SignalHistory *history, QObject *receiver,
+                           QObject *parent)
+    : QObject(parent)
+    , serverUrl(serverUrl)
+    , scheduler(scheduler)
+    , history(history)
+    , receiver(receiver)
+    , lastActiveNs(0)
+    , speedSlot(SignalSchema::vehicle().indexOf("speed"))
+    , updateTimer(nullptr)
+    , streamRetryTimer(nullptr)
+    , stalenessTimer(nullptr)
+    , network(nullptr)
+    , derived(SignalSchema::vehicle(), batteryCapacityKwh)
+    , staleness(SignalSchema::vehicle().size(), qint64(STALE_TICK_MS) * 1000000,
+                PollScheduler::now())
+    , locallyStale(SignalSchema::vehicle().size(), 0)
+    , lastTimestamps(SignalSchema::vehicle().size(), 0)
+    , consumed(0)
+    , takenUpdates(0)
+    , notifyQueued(false)
+{
+    state.samples.resize(SignalSchema::vehicle().size());
+    state.versions.resize(SignalSchema::vehicle().size(), 0);
+    expired.reserve(SignalSchema::vehicle().size());
+    derivedUpdated.reserve(SignalSchema::vehicle().size());
+    fresh.reserve(SignalSchema::vehicle().size());
+    // Polls speed up around the same warnings the threshold engine raises
+    std::vector<ThresholdRule> rules = ThresholdEngine::defaultRules(SignalSchema::vehicle());
+    for (int slot = 0; slot < int(rules.size()); ++slot) {
+        if (rules[slot].enabled) {
+            warningLevels.push_back({slot, rules[slot].warning});
+        }
+    }
+}
+
+void IngestWorker::start()
+{
+    // Created here rather than in the constructor so the timers and the
+    // QNetworkAccessManager belong to the ingest thread
+    updateTimer = new QTimer(this);
+    streamRetryTimer = new QTimer(this);
+    stalenessTimer = new QTimer(this);
+    network = new NetworkManager(serverUrl, this);
+
+    connect(network, &NetworkManager::dataReceived,
+            this, &IngestWorker::handleDataReceived);
+    connect(network, &NetworkManager::systemStatusReceived,
+            this, &IngestWorker::handleStatusReceived);
+    connect(network, &NetworkManager::error,
+            this, &IngestWorker::error);
+    connect(network, &NetworkManager::streamStateChanged,
+            this, &IngestWorker::handleStreamStateChanged);
+    connect(network, &NetworkManager::requestStatsChanged,
+            this, &IngestWorker::publishStats);
+
+    // Polls are rescheduled one at a time against the frame clock; idle
+    // polling keeps the spec's 100ms (faster for shared memory)
+    scheduler->setIdleInterval(qint64(network->pollInterval()) * 1000000);
+    updateTimer->setSingleShot(true);
+    updateTimer->setTimerType(Qt::PreciseTimer);
+    connect(updateTimer, &QTimer::timeout,
+            this, &IngestWorker::updateData);
+
+    // Poll until the push stream is up, retrying it every STREAM_RETRY_MS
+    streamRetryTimer->setInterval(STREAM_RETRY_MS);
+    connect(streamRetryTimer, &QTimer::timeout,
+            network, &NetworkManager::startStream);
+
+    // Ticks only while some signal is still fresh
+    stalenessTimer->setInterval(STALE_TICK_MS);
+    connect(stalenessTimer, &QTimer::timeout,
+            this, &IngestWorker::expireStaleSignals);
+
+    scheduleUpdate();
+    streamRetryTimer->start();
+    network->startStream();
+}
+
+void IngestWorker::resetTrip()
+{
+    derived.resetTrip();
+}
+
+bool IngestWorker::takeSnapshot(VehicleSnapshot &snapshot)
+{
+    // Cleared before looking: an update racing with this take queues a
+    // fresh notification instead of being lost
+    notifyQueued.store(false, std::memory_order_release);
+
+    snapshot.changed.clear();
+    snapshot.statusChanged = false;
+    snapshot.published = 0;
+    snapshot.receivedNs = 0;
+    if (!states.update()) {
+        return false;
+    }
+
+    // The front buffer is ours until the next update(), so it cannot
+    // change under us; versions say which slots moved since the last take
+    const VehicleState &latest = states.readBuffer();
+    const quint64 taken = consumed.load(std::memory_order_relaxed);
+    if (snapshot.samples.size() != latest.samples.size()) {
+        snapshot.samples.resize(latest.samples.size());
+    }
+    for (std::size_t index = 0; index < latest.samples.size(); ++index) {
+        if (latest.versions[index] > taken) {
+            snapshot.samples[index] = latest.samples[index];
+            snapshot.changed.push_back(int(index));
+        }
+    }
+
+    snapshot.status = latest.status;
+    snapshot.statusChanged = latest.statusVersion > taken;
+    snapshot.streaming = latest.streaming;
+    snapshot.requestStats = latest.requestStats;
+    snapshot.decodeStats = latest.decodeStats;
+    snapshot.published = latest.updates - takenUpdates;
+    snapshot.receivedNs = latest.receivedNs;
+    snapshot.allocations = latest.allocations;
+    takenUpdates = latest.updates;
+    consumed.store(latest.sequence, std::memory_order_release);
+    return true;
+}
+
+void IngestWorker::updateData()
+{
+    network->fetchSnapshot();
+    scheduleUpdate();
+}
+
+void IngestWorker::scheduleUpdate()
+{
+    qint64 delayNs = scheduler->nextFetchDelay(PollScheduler::now());
+    updateTimer->start(int((delayNs + 500000) / 1000000));
+}
+
+void IngestWorker::updateMode(const SignalTable &table)
+{
+    bool active = table.at(speedSlot).valid && table.at(speedSlot).value > MOVING_SPEED_KMH;
+    for (std::size_t i = 0; i < warningLevels.size() && !active; ++i) {
+        const WarningLevel &warning = warningLevels[i];
+        const SignalSample &sample = table.at(warning.slot);
+        active = sample.valid
+                 && std::abs(sample.value - warning.level) <= warning.level * NEAR_FRACTION;
+    }
+
+    qint64 now = PollScheduler::now();
+    if (active) {
+        lastActiveNs = now;
+        scheduler->setMode(PollScheduler::Active);
+    } else if (now - lastActiveNs > IDLE_AFTER_NS) {
+        scheduler->setMode(PollScheduler::Idle);
+    }
+}
+
+void IngestWorker::handleDataReceived(const SignalTable &table)
+{
+    qint64 receivedNs = PollScheduler::now();
+    if (!network->isStreaming()) {
+        scheduler->fetchCompleted(network->requestStats().roundTripNs);
+    }
+    updateMode(table);
+    derivedUpdated.clear();
+    derived.update(table, derivedUpdated);
+    
+    // Shared memory and full replies re-send every slot, so only a newer
+    // source timestamp counts as a sample: anything else would keep a
+    // signal that stopped updating fresh and repeat points in its history.
+    // The rings are lock-free; the GUI thread reads them while we write.
+    const qint64 staleAfterNs = qint64(STALE_THRESHOLD_MS) * 1000000;
+    fresh.clear();
+    for (int index : table.updated()) {
+        const SignalSample &sample = table.at(index);
+        if (isNewSample(index, sample)) {
+            history->at(index).push(sample.timestamp, sample.value);
+            staleness.schedule(index, receivedNs + staleAfterNs);
+            fresh.push_back(index);
+        }
+    }
+    for (int index : derivedUpdated) {
+        const SignalSample &sample = derived.at(index);
+        if (isNewSample(index, sample)) {
+            history->at(index).push(sample.timestamp, sample.value);
+            staleness.schedule(index, receivedNs + staleAfterNs);
+            fresh.push_back(index);
+        }
+    }
+    if (staleness.pending() > 0 && !stalenessTimer->isActive()) {
+        stalenessTimer->start();
+    }
+
+    // A signal stays stale until a newer sample arrives, whatever its value
+    for (int index : table.changed()) {
+        state.samples[index] = table.at(index);
+        state.samples[index].stale |= bool(locallyStale[index]);
+        markChanged(index);
+    }
+    for (int index : derivedUpdated) {
+        const SignalSample &sample = derived.at(index);
+        SignalSample &current = state.samples[index];
+        bool stale = sample.stale || locallyStale[index];
+        bool changed = current.value != sample.value || current.valid != sample.valid
+                       || current.stale != stale;
+        current = sample;
+        current.stale = stale;
+        if (changed) {
+            markChanged(index);
+        }
+    }
+    // Every newer sample goes out, even with its value unchanged, so the
+    // interpolator sees each timestamp; it also ends local staleness
+    for (int index : fresh) {
+        locallyStale[index] = 0;
+        state.samples[index] = derived.isDerived(index) ? derived.at(index) : table.at(index);
+        markChanged(index);
+    }
+    state.decodeStats = network->decodeStats();
+    ++state.updates;
+    publish(receivedNs);
+}
+
+bool IngestWorker::isNewSample(int index, const SignalSample &sample)
+{
+    // A repeat is no older than the last sample by more than the stale
+    // threshold; further back, the source restarted or its clock stepped
+    // back, and waiting for it to catch up would leave the signal stale
+    std::int64_t last = lastTimestamps[index];
+    if (!sample.valid
+            || (sample.timestamp <= last && last - sample.timestamp <= STALE_THRESHOLD_MS)) {
+        return false;
+    }
+    lastTimestamps[index] = sample.timestamp;
+    return true;
+}
+
+void IngestWorker::handleStatusReceived(const SystemStatus &status)
+{
+    state.status = status;
+    state.statusVersion = state.sequence + 1;
+    ++state.updates;
+    publish(0);
+}
+
+void IngestWorker::handleStreamStateChanged(bool active)
+{
+    // The stream carries both latest values and status, so polling is
+    // only needed as a fallback while it is down
+    if (active) {
+        updateTimer->stop();
+        streamRetryTimer->stop();
+        network->cancelPendingRequests();
+    } else {
+        scheduleUpdate();
+        streamRetryTimer->start();
+    }
+
+    state.streaming = active;
+    publish(0);
+}
+
+void IngestWorker::publishStats()
+{
+    state.requestStats = network->requestStats();
+    publish(0, false);  // Rides along with the next data notification
+}
+
+void IngestWorker::expireStaleSignals()
+{
+    expired.clear();
+    staleness.advance(PollScheduler::now(), expired);
+    if (staleness.pending() == 0) {
+        stalenessTimer->stop();
+    }
+    if (expired.empty()) {
+        return;
+    }
+
+    for (int index : expired) {
+        locallyStale[index] = 1;
+        state.samples[index].stale = true;
+        markChanged(index);
+    }
+    publish(0);
+}
+
+void IngestWorker::markChanged(int index)
+{
+    // Stamped with the sequence publish() is about to give the state
+    state.versions[index] = state.sequence + 1;
+}
+
+void IngestWorker::publish(qint64 receivedNs, bool wake)
+{
+    // Once the GUI thread has taken everything published so far, the next
+    // arrival is the oldest it has not seen
+    if (consumed.load(std::memory_order_acquire) >= state.sequence) {
+        state.receivedNs = 0;
+    }
+    if (state.receivedNs == 0) {
+        state.receivedNs = receivedNs;
+    }
+    ++state.sequence;
+    state.allocations = allocations::thisThread();
+
+    // Once each buffer has been filled the copy reuses its storage
+    states.writeBuffer() = state;
+    states.publish();
+    if (wake) {
+        notify();
+    }
+}
+
+void IngestWorker::notify()
+{
+    if (!notifyQueued.exchange(true, std::memory_order_acq_rel)) {
+        QCoreApplication::postEvent(receiver, new SnapshotReadyEvent);
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef INGESTWORKER_H
+#define INGESTWORKER_H
+
+#include <QtCore/QEvent>
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "derivedsignals.h"
+#include "networkmanager.h"
+#include "pollscheduler.h"
+#include "signalhistory.h"
+#include "timerwheel.h"
+#include "triplebuffer.h"
+
+// Complete state of the vehicle as of one ingest update, published as a
+// whole so every signal in it is from the same moment
+struct VehicleState {
+    std::vector<SignalSample> samples;
+    std::vector<quint64> versions;  // Sequence at which each slot last changed
+    quint64 sequence = 0;           // Bumped by every publish
+    quint64 updates = 0;            // Data and status updates so far
+    SystemStatus status;
+    quint64 statusVersion = 0;
+    bool streaming = false;
+    NetworkManager::RequestStats requestStats;
+    NetworkManager::DecodeStats decodeStats;
+    qint64 receivedNs = 0;   // Oldest arrival the GUI thread has not taken
+    quint64 allocations = 0; // On the ingest thread so far, see allocationcounter.h
+};
+
+// Everything the GUI thread needs from one or more ingest updates
+struct VehicleSnapshot {
+    std::vector<SignalSample> samples;
+    std::vector<int> changed;  // Slots updated since the previous take
+    SystemStatus status;
+    bool statusChanged = false;
+    bool streaming = false;
+    NetworkManager::RequestStats requestStats;
+    NetworkManager::DecodeStats decodeStats;
+    quint64 published = 0;  // Ingest updates folded into this snapshot
+    qint64 receivedNs = 0;  // Arrival of the oldest of them, PollScheduler::now()
+    quint64 allocations = 0;
+};
+
+// Posted to the GUI thread when a new state is published. At most one is
+// normally queued (see IngestWorker::notify()), so it is placed in a fixed
+// slot instead of on the heap, where a queued signal would put an event
+// for every wake-up.
+class SnapshotReadyEvent : public QEvent {
+public:
+    static const QEvent::Type SnapshotReady = QEvent::Type(QEvent::User + 1);
+
+    SnapshotReadyEvent();
+
+    static void *operator new(std::size_t size);
+    static void operator delete(void *pointer);
+};
+
+// Owns the network stack on a dedicated thread: polling, the push stream
+// and payload decoding all happen here. Each update is applied to the
+// worker's VehicleState, which is then published whole through a triple
+// buffer; the GUI thread picks up the newest one with takeSnapshot(),
+// without locks, and `receiver` is sent at most one SnapshotReadyEvent
+// until it does, however many updates arrive in between. Once warmed up,
+// nothing from the bytes received to the published state allocates.
+// Polls are timed by the shared PollScheduler, and every sample is
+// appended to its signal's history ring as it arrives.
+// A signal not heard from for STALE_THRESHOLD_MS is marked stale, driven
+// by a timer wheel, and fresh again with its next sample. Derived signals
+// are computed here too and then treated like decoded ones.
+class IngestWorker : public QObject {
+    Q_OBJECT
+
+public:
+    static const int STALE_THRESHOLD_MS = 500;
+    static const int STALE_TICK_MS = 25;  // Staleness is flagged this late at most
+    static const int STREAM_RETRY_MS = 1000;
+    
+    IngestWorker(const QUrl &serverUrl, double batteryCapacityKwh, PollScheduler *scheduler,
+                 SignalHistory *history, QObject *receiver, QObject *parent = nullptr);
+
+    // GUI thread only. Copies the slots changed since the last take from
+    // the newest published state; returns false if there is none.
+    bool takeSnapshot(VehicleSnapshot &snapshot);
+
+public slots:
+    void start();
+    void resetTrip();
+
+signals:
+    void error(const QString &message);
+
+private slots:
+    void updateData();
+    void handleDataReceived(const SignalTable &table);
+    void handleStatusReceived(const SystemStatus &status);
+    void handleStreamStateChanged(bool active);
+    void publishStats();
+    void expireStaleSignals();
+
+private:
+    QUrl serverUrl;
+    PollScheduler *scheduler;
+    SignalHistory *history;
+    QObject *receiver;  // Of SnapshotReadyEvent, on the GUI thread
+    qint64 lastActiveNs;
+    int speedSlot;
+    struct WarningLevel {
+        int slot;
+        double level;
+    };
+    std::vector<WarningLevel> warningLevels;  // Of ThresholdEngine's default rules
+    QTimer *updateTimer;
+    QTimer *streamRetryTimer;
+    QTimer *stalenessTimer;
+    NetworkManager *network;
+    DerivedSignals derived;
+    std::vector<int> derivedUpdated;
+    TimerWheel staleness;               // Deadline per slot, PollScheduler::now()
+    std::vector<char> locallyStale;
+    std::vector<std::int64_t> lastTimestamps;  // Newest source timestamp per slot
+    std::vector<int> fresh;                    // Slots with a newer sample this update
+    std::vector<int> expired;
+
+    VehicleState state;  // Being updated; copied out by publish()
+    TripleBuffer<VehicleState> states;
+    std::atomic<quint64> consumed;  // Sequence of the last take
+    quint64 takenUpdates;           // GUI thread only
+    std::atomic<bool> notifyQueued;
+
+    void markChanged(int index);
+    bool isNewSample(int index, const SignalSample &sample);
+    void publish(qint64 receivedNs, bool wake = true);
+    void notify();
+    void scheduleUpdate();
+    void updateMode(const SignalTable &table);
+};
+
+#endif // INGESTWORKER_H
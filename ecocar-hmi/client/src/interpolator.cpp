@@ -0,0 +1,143 @@
+#include "interpolator.h"
+#include <algorithm>
+
+Interpolator::Interpolator(int signalCount)
+    : tracks(signalCount)
+    , horizon(DEFAULT_HORIZON_MS)
+    , offset(0)
+    , jitter(0)
+    , hasOffset(false)
+{
+}
+
+void Interpolator::setMode(int slot, Mode mode)
+{
+    tracks[slot].mode = mode;
+}
+
+Interpolator::Mode Interpolator::mode(int slot) const
+{
+    return tracks[slot].mode;
+}
+
+void Interpolator::setHorizon(std::int64_t horizonMs)
+{
+    horizon = std::max<std::int64_t>(0, horizonMs);
+}
+
+void Interpolator::add(int slot, std::int64_t timestampMs, double value, std::int64_t arrivalMs)
+{
+    Track &track = tracks[slot];
+    if (track.count > 0) {
+        const Point &last = point(track, 0);
+        if (timestampMs <= last.timestamp && last.timestamp - timestampMs <= MAX_DELAY_MS) {
+            return;  // Late or repeated
+        }
+        if (timestampMs < last.timestamp) {
+            // Too far back to be late: the source restarted or its clock
+            // stepped back, so start over from this sample
+            track.count = 0;
+            track.interval = 0;
+            hasOffset = false;
+        } else {
+            std::int64_t spacing = timestampMs - last.timestamp;
+            track.interval = track.interval == 0 ? spacing
+                                                 : track.interval + (spacing - track.interval) / 4;
+        }
+    }
+    track.newest = (track.newest + 1) % DEPTH;
+    track.points[track.newest] = {timestampMs, value};
+    track.count = std::min(track.count + 1, DEPTH);
+
+    // The fastest delivery is the best guess at the clock offset; creep
+    // up slowly so a clock step on either side is followed eventually
+    std::int64_t candidate = arrivalMs - timestampMs;
+    if (!hasOffset || candidate < offset) {
+        offset = candidate;
+        hasOffset = true;
+    } else {
+        offset += (candidate - offset) / 64;
+    }
+    std::int64_t late = candidate - offset;
+    jitter = late > jitter ? late : jitter - (jitter - late) / 32;
+}
+
+void Interpolator::clear(int slot)
+{
+    tracks[slot].count = 0;
+    tracks[slot].newest = -1;
+    tracks[slot].interval = 0;
+}
+
+bool Interpolator::valueAt(int slot, std::int64_t nowMs, double &value) const
+{
+    const Track &track = tracks[slot];
+    if (track.count == 0) {
+        return false;
+    }
+    const Point &newest = point(track, 0);
+    std::int64_t time = renderTime(track, nowMs);
+
+    if (time >= newest.timestamp) {
+        if (track.mode != Extrapolate || track.count < 2) {
+            value = newest.value;
+            return true;
+        }
+        const Point &previous = point(track, 1);
+        double slope = (newest.value - previous.value)
+                       / double(newest.timestamp - previous.timestamp);
+        value = newest.value + slope * double(std::min(time - newest.timestamp, horizon));
+        return true;
+    }
+
+    // Between two samples we still have, or before all of them
+    for (int age = 1; age < track.count; ++age) {
+        const Point &before = point(track, age);
+        if (time >= before.timestamp) {
+            const Point &after = point(track, age - 1);
+            double t = double(time - before.timestamp) / double(after.timestamp - before.timestamp);
+            value = before.value + (after.value - before.value) * t;
+            return true;
+        }
+    }
+    value = point(track, track.count - 1).value;
+    return true;
+}
+
+bool Interpolator::isMoving(int slot, std::int64_t nowMs) const
+{
+    const Track &track = tracks[slot];
+    if (track.count < 2) {
+        return false;
+    }
+    const Point &newest = point(track, 0);
+    std::int64_t time = renderTime(track, nowMs);
+    if (track.mode == Extrapolate) {
+        return time < newest.timestamp + horizon && newest.value != point(track, 1).value;
+    }
+    return time < newest.timestamp;
+}
+
+std::int64_t Interpolator::latency(int slot) const
+{
+    return delay(tracks[slot]);
+}
+
+const Interpolator::Point &Interpolator::point(const Track &track, int age) const
+{
+    return track.points[(track.newest - age + DEPTH) % DEPTH];
+}
+
+std::int64_t Interpolator::delay(const Track &track) const
+{
+    // Far enough back that the next sample has usually arrived
+    if (track.mode != Interpolate) {
+        return 0;
+    }
+    return std::min(track.interval + jitter, MAX_DELAY_MS);
+}
+
+std::int64_t Interpolator::renderTime(const Track &track, std::int64_t nowMs) const
+{
+    return nowMs - offset - delay(track);
+}
@@ -0,0 +1,74 @@
+#ifndef INTERPOLATOR_H
+#define INTERPOLATOR_H
+
+#include <cstdint>
+#include <vector>
+
+// Turns timestamped samples into a value for any render time, so gauges
+// move every frame instead of stepping at the poll rate. Per signal:
+//  - Interpolate: the value one sample interval (plus the usual delivery
+//    jitter) ago, between the two samples around it. Smooth and only as
+//    wrong as a straight line between samples, at that fixed latency.
+//  - Extrapolate: the current value, projected from the last two samples
+//    for at most the horizon, then held. No added latency, but it
+//    overshoots when the signal turns.
+// Source timestamps are mapped onto the local clock through the smallest
+// delay seen between a sample's timestamp and its arrival.
+class Interpolator {
+public:
+    enum Mode {
+        Off,
+        Interpolate,
+        Extrapolate
+    };
+
+    static constexpr std::int64_t DEFAULT_HORIZON_MS = 150;
+    static constexpr std::int64_t MAX_DELAY_MS = 250;  // Bounds the interpolation latency
+
+    explicit Interpolator(int signalCount);
+
+    void setMode(int slot, Mode mode);
+    Mode mode(int slot) const;
+    void setHorizon(std::int64_t horizonMs);
+
+    // `arrivalMs` is when the sample reached us, on the local clock.
+    // Samples up to MAX_DELAY_MS older than the newest are dropped; further
+    // back, the signal starts over from them.
+    void add(int slot, std::int64_t timestampMs, double value, std::int64_t arrivalMs);
+    void clear(int slot);
+
+    // Value to show at local time `nowMs`; false before any sample
+    bool valueAt(int slot, std::int64_t nowMs, double &value) const;
+    // Whether valueAt() still changes after `nowMs` without new samples
+    bool isMoving(int slot, std::int64_t nowMs) const;
+    // How far the shown value trails the source, in ms
+    std::int64_t latency(int slot) const;
+
+private:
+    static constexpr int DEPTH = 4;  // Samples kept per signal
+
+    struct Point {
+        std::int64_t timestamp;
+        double value;
+    };
+
+    struct Track {
+        Mode mode = Off;
+        Point points[DEPTH];
+        int count = 0;
+        int newest = -1;           // Index into points
+        std::int64_t interval = 0; // Sample spacing, smoothed
+    };
+
+    const Point &point(const Track &track, int age) const;
+    std::int64_t delay(const Track &track) const;
+    std::int64_t renderTime(const Track &track, std::int64_t nowMs) const;
+
+    std::vector<Track> tracks;
+    std::int64_t horizon;
+    std::int64_t offset;  // Local minus source time, smallest seen
+    std::int64_t jitter;  // How much later than that samples arrive, peak
+    bool hasOffset;
+};
+
+#endif // INTERPOLATOR_H
@@ -0,0 +1,89 @@
+#include "localtransport.h"
+#include <QtCore/QtEndian>
+#include <cstring>
+
+LocalTransport::LocalTransport(const QString &path, QObject *parent)
+    : QObject(parent)
+    , socket(new QLocalSocket(this))
+    , path(path)
+{
+    readBuffer.reserve(64 * 1024);
+    writeBuffer.reserve(256);
+
+    connect(socket, &QLocalSocket::connected, this, &LocalTransport::connected);
+    connect(socket, &QLocalSocket::disconnected, this, &LocalTransport::disconnected);
+    connect(socket, &QLocalSocket::errorOccurred, this, [this]() {
+        // A failed connect never reaches disconnected()
+        if (socket->state() == QLocalSocket::UnconnectedState) {
+            emit disconnected();
+        }
+    });
+    connect(socket, &QLocalSocket::readyRead, this, &LocalTransport::handleReadyRead);
+}
+
+void LocalTransport::connectToServer()
+{
+    if (socket->state() == QLocalSocket::UnconnectedState) {
+        readBuffer.resize(0);  // Keeps the capacity
+        socket->connectToServer(path);
+    }
+}
+
+void LocalTransport::abort()
+{
+    socket->abort();
+}
+
+bool LocalTransport::isConnected() const
+{
+    return socket->state() == QLocalSocket::ConnectedState;
+}
+
+void LocalTransport::sendRequest(FrameKind kind, quint64 sinceSequence, const QByteArray &sinceEpoch)
+{
+    const qsizetype payloadSize = 8 + sinceEpoch.size();
+    writeBuffer.resize(4 + 2 + payloadSize);
+    char *out = writeBuffer.data();
+    qToBigEndian(quint32(2 + payloadSize), out);
+    out[4] = kind;
+    out[5] = 'C';  // Replies in CBOR
+    qToBigEndian(sinceSequence, out + 6);
+    std::memcpy(out + 14, sinceEpoch.constData(), size_t(sinceEpoch.size()));
+    socket->write(writeBuffer);
+}
+
+void LocalTransport::handleReadyRead()
+{
+    // Appended in place rather than through readAll(), which would
+    // allocate a new array for every read
+    qsizetype buffered = readBuffer.size();
+    qint64 available = socket->bytesAvailable();
+    readBuffer.resize(buffered + qsizetype(available));
+    qint64 read = socket->read(readBuffer.data() + buffered, available);
+    readBuffer.resize(buffered + qsizetype(qMax<qint64>(read, 0)));
+
+    qsizetype offset = 0;
+    while (readBuffer.size() - offset >= 4) {
+        const char *frame = readBuffer.constData() + offset;
+        quint32 length = qFromBigEndian<quint32>(frame);
+        if (length < 2 || length > MAX_FRAME_SIZE) {
+            // Framing is lost; drop the connection and let the caller retry
+            socket->abort();
+            return;
+        }
+        if (readBuffer.size() - offset < qsizetype(4 + length)) {
+            break;
+        }
+        emit frameReceived(frame[4], frame[5] == 'C', frame + 6, qsizetype(length) - 2);
+        if (!isConnected()) {
+            readBuffer.resize(0);  // Receiver dropped the connection
+            return;
+        }
+        offset += 4 + length;
+    }
+    if (offset > 0) {
+        qsizetype rest = readBuffer.size() - offset;
+        std::memmove(readBuffer.data(), readBuffer.constData() + offset, size_t(rest));
+        readBuffer.resize(rest);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef LOCALTRANSPORT_H
+#define LOCALTRANSPORT_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtNetwork/QLocalSocket>
+
+// Length-prefixed framing over a Unix domain socket, for a server on the
+// same board. Every frame is
+//
+//     u32 length (big endian, counts everything after it)
+//     u8  kind    'L' latest, 'T' status, 'P' snapshot, 'W' watch, 'K' keepalive
+//     u8  format  'C' CBOR, 'J' JSON
+//     payload
+//
+// Requests carry the delta position as u64 sequence + epoch bytes; replies
+// and pushed updates carry the same payloads as the HTTP endpoints.
+class LocalTransport : public QObject {
+    Q_OBJECT
+
+public:
+    enum FrameKind : char {
+        Latest = 'L',
+        Status = 'T',
+        Snapshot = 'P',
+        Watch = 'W',
+        Keepalive = 'K'
+    };
+
+    explicit LocalTransport(const QString &path, QObject *parent = nullptr);
+
+    void connectToServer();
+    void abort();
+    bool isConnected() const;
+
+    void sendRequest(FrameKind kind, quint64 sinceSequence, const QByteArray &sinceEpoch);
+
+signals:
+    void connected();
+    void disconnected();
+    // `data` is only valid during the emission
+    void frameReceived(char kind, bool cbor, const char *data, qsizetype size);
+
+private:
+    static const qsizetype MAX_FRAME_SIZE = 1 << 20;
+
+    QLocalSocket *socket;
+    QString path;
+    QByteArray readBuffer;
+    QByteArray writeBuffer;
+
+    void handleReadyRead();
+};
+
+#endif // LOCALTRANSPORT_H
@@ -1,7 +1,11 @@
+#include <QCommandLineParser>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include <QQmlContext>
 #include <QQuickStyle>
+#include <QQuickWindow>
 #include <QScreen>
+#include "datamodel.h"
 
 int main(int argc, char *argv[])
 {
@@ -15,7 +19,33 @@ int main(int argc, char *argv[])
     // Use the Material style for better touch support
     QQuickStyle::setStyle("Material");
 
+    // Data source: the spec's HTTP API by default; on the same board also a
+    // Unix domain socket (unix:/path), shared memory (shm:/name) or the CAN
+    // bus itself (can:can0)
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption serverOption("server",
+                                    "Data source (http://..., unix:/path, shm:/name or can:iface)",
+                                    "url",
+                                    NetworkManager::defaultServerUrl().toString());
+    parser.addOption(serverOption);
+    QCommandLineOption historyOption("history", "Seconds of signal history kept for charts",
+                                     "seconds",
+                                     QString::number(DataModel::DEFAULT_HISTORY_SECONDS));
+    parser.addOption(historyOption);
+    QCommandLineOption capacityOption("battery-capacity",
+                                      "Usable battery energy in kWh, for range (unknown by default)",
+                                      "kwh", "0");
+    parser.addOption(capacityOption);
+    parser.process(app);
+
+    // Expose live vehicle data to QML as `dataModel`. Declared before the
+    // engine so it outlives the bindings that refer to it.
+    DataModel dataModel(QUrl(parser.value(serverOption)), parser.value(historyOption).toInt(),
+                        parser.value(capacityOption).toDouble());
+
     QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("dataModel", &dataModel);
 
     // Set the target screen resolution
     QScreen *screen = QGuiApplication::primaryScreen();
@@ -32,6 +62,13 @@ int main(int argc, char *argv[])
         }, Qt::QueuedConnection);
 
     engine.load(url);
+    
+    // Poll against the dashboard's frame clock
+    if (!engine.rootObjects().isEmpty()) {
+        if (QQuickWindow *window = qobject_cast<QQuickWindow *>(engine.rootObjects().first())) {
+            dataModel.attachWindow(window);
+        }
+    }
 
     return app.exec();
 }
\ No newline at end of file
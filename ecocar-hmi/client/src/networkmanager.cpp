@@ -1,32 +1,166 @@
 #include "networkmanager.h"
-#include <QtCore/QJsonDocument>
 #include <QtNetwork/QNetworkRequest>
+#include <cstring>
+#include "pollscheduler.h"
 
-NetworkManager::NetworkManager(QObject *parent)
+// resolved() drops the last path segment unless the base ends in '/'
+static QUrl withTrailingSlash(QUrl url)
+{
+    if (url.scheme().startsWith(QLatin1String("http")) && !url.path().endsWith('/')) {
+        url.setPath(url.path() + '/');
+    }
+    return url;
+}
+
+NetworkManager::NetworkManager(const QUrl &serverUrl, QObject *parent)
     : QObject(parent)
     , manager(new QNetworkAccessManager(this))
-    , baseUrl(QUrl("http://localhost:5000/api/v1"))  // From the spec
+    , baseUrl(withTrailingSlash(serverUrl))
+    , local(nullptr)
+    , shared(nullptr)
+    , can(nullptr)
+    , canDecoder(SignalSchema::vehicle())
+    , canStatusTimer(nullptr)
+    , canFrames(0)
+    , canErrors(0)
+    , snapshotEndpoint(makeEndpoint("can/snapshot", &NetworkManager::decodeSnapshot, true))
+    , deltaSequence(0)
+    , table(SignalSchema::vehicle().size())
+    , decoder(SignalSchema::vehicle())
+    , streamWatchdog(new QTimer(this))
+    , m_streaming(false)
+    , streamCarriageReturn(false)
 {
+    // The server sends a keepalive comment every second; two missed
+    // keepalives means the stream is dead even if TCP has not noticed yet
+    streamWatchdog->setInterval(2500);
+    streamWatchdog->setSingleShot(true);
+    connect(streamWatchdog, &QTimer::timeout, this, &NetworkManager::stopStream);
+    
+    if (baseUrl.scheme() == QLatin1String("unix")) {
+        local = new LocalTransport(baseUrl.path(), this);
+        connect(local, &LocalTransport::connected,
+                this, &NetworkManager::handleLocalConnected);
+        connect(local, &LocalTransport::disconnected,
+                this, &NetworkManager::handleLocalDisconnected);
+        connect(local, &LocalTransport::frameReceived,
+                this, &NetworkManager::handleLocalFrame);
+    } else if (baseUrl.scheme() == QLatin1String("shm")) {
+        shared = new ShmSnapshotReader(SignalSchema::vehicle());
+        sharedName = baseUrl.path().toLocal8Bit();
+    } else if (baseUrl.scheme() == QLatin1String("can")) {
+        can = new CanSocket(baseUrl.path(), this);
+        can->setFilter(CanDecoder::messageIds());
+        connect(can, &CanSocket::framesReceived, this, &NetworkManager::handleCanFrames);
+        connect(can, &CanSocket::closed, this, &NetworkManager::handleCanClosed);
+        // The bus has no status message; derive one like the backend does
+        canStatusTimer = new QTimer(this);
+        canStatusTimer->setInterval(1000);
+        connect(canStatusTimer, &QTimer::timeout, this, &NetworkManager::publishCanStatus);
+    }
 }
 
-void NetworkManager::fetchLatestData()
+NetworkManager::~NetworkManager()
 {
-    QUrl url = baseUrl.resolved(QUrl("can/latest"));
-    QNetworkRequest request(url);
-    
-    QNetworkReply *reply = manager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        handleNetworkReply(reply);
-        reply->deleteLater();
-    });
+    delete shared;
 }
 
-void NetworkManager::fetchSystemStatus()
+QUrl NetworkManager::defaultServerUrl()
 {
-    QUrl url = baseUrl.resolved(QUrl("can/status"));
-    QNetworkRequest request(url);
+    return QUrl("http://localhost:5000/api/v1/");  // From the spec
+}
+
+int NetworkManager::pollInterval() const
+{
+    // Shared memory costs no syscall to read, so it is sampled once per
+    // display frame (TARGET_FPS 60) even when idle; HTTP stays at the
+    // spec's 100ms
+    return shared ? 16 : 100;
+}
+
+NetworkManager::Endpoint NetworkManager::makeEndpoint(const char *path, ReplyDecoder decoder,
+                                                      bool delta) const
+{
+    Endpoint endpoint;
+    endpoint.request = QNetworkRequest(baseUrl.resolved(QUrl(QString::fromLatin1(path))));
+    // Prefer compact CBOR; servers that only speak JSON ignore it
+    endpoint.request.setRawHeader("Accept", "application/cbor, application/json;q=0.5");
+    endpoint.decoder = decoder;
+    endpoint.delta = delta;
+    return endpoint;
+}
+
+void NetworkManager::fetchSnapshot()
+{
+    if (local) {
+        sendLocalRequest(LocalTransport::Snapshot);
+        return;
+    }
+    if (shared) {
+        readSharedMemory();
+        return;
+    }
+    if (can) {
+        return;
+    }
+    sendRequest(snapshotEndpoint);
+}
+
+NetworkManager::RequestStats NetworkManager::requestStats() const
+{
+    return stats;
+}
+
+NetworkManager::DecodeStats NetworkManager::decodeStats() const
+{
+    return formatStats;
+}
+
+void NetworkManager::cancelPendingRequests()
+{
+    while (!inFlight.isEmpty()) {
+        abortRequest(0);
+    }
+    emit requestStatsChanged();
+}
+
+void NetworkManager::abortRequest(qsizetype index)
+{
+    // Forget the request first so its finished signal is ignored
+    QNetworkReply *reply = inFlight.takeAt(index).reply;
+    ++stats.cancelled;
+    reply->abort();
+}
+
+void NetworkManager::sendRequest(Endpoint &endpoint)
+{
+    // Never queue behind a slow server: while a request to this endpoint is
+    // outstanding, skip the tick; once it is older than the staleness
+    // threshold its answer is useless, so replace it
+    for (qsizetype i = 0; i < inFlight.size(); ++i) {
+        if (inFlight[i].endpoint != &endpoint) {
+            continue;
+        }
+        if (inFlight[i].age.elapsed() < REQUEST_TIMEOUT_MS) {
+            ++stats.dropped;
+            emit requestStatsChanged();
+            return;
+        }
+        abortRequest(i);
+        break;
+    }
+    
+    if (endpoint.delta) {
+        setDeltaHeaders(endpoint.request);
+    }
+    
+    QNetworkReply *reply = manager->get(endpoint.request);
+    PendingRequest pending{reply, &endpoint, QElapsedTimer()};
+    pending.age.start();
+    inFlight.append(pending);
+    ++stats.sent;
+    emit requestStatsChanged();
     
-    QNetworkReply *reply = manager->get(request);
     connect(reply, &QNetworkReply::finished, this, [this, reply]() {
         handleNetworkReply(reply);
         reply->deleteLater();
@@ -35,26 +169,469 @@ void NetworkManager::fetchSystemStatus()
 
 void NetworkManager::handleNetworkReply(QNetworkReply *reply)
 {
+    qsizetype index = -1;
+    for (qsizetype i = 0; i < inFlight.size(); ++i) {
+        if (inFlight[i].reply == reply) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        return;  // Aborted, already counted as cancelled
+    }
+    PendingRequest pending = inFlight.takeAt(index);
+    
     if (reply->error() != QNetworkReply::NoError) {
         emit error(reply->errorString());
         return;
     }
 
-    QByteArray data = reply->readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
+    // Read into a buffer kept from reply to reply rather than readAll()
+    receiveBuffer.resize(qsizetype(reply->bytesAvailable()));
+    qint64 size = reply->read(receiveBuffer.data(), receiveBuffer.size());
+    QByteArray type = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+    PayloadHeader header;
     
-    if (doc.isNull()) {
-        emit error("Invalid JSON response");
+    if (size < 0
+            || !decodePayload(receiveBuffer.constData(), qsizetype(size),
+                              type.startsWith("application/cbor"), &header)) {
+        emit error("Invalid response payload");
         return;
     }
 
-    QJsonObject json = doc.object();
+    ++stats.completed;
+    stats.roundTripNs = pending.age.nsecsElapsed();
+    emit requestStatsChanged();
+    // Only one poll per endpoint is ever outstanding, so replies cannot
+    // overtake each other; acceptDelta() still drops data older than what
+    // the stream applied, or the stream's first event older than a poll
+    (this->*pending.endpoint->decoder)(header);
+    table.discard();  // Drops anything the decoder did not commit
+}
+
+bool NetworkManager::decodePayload(const char *data, qsizetype size, bool cbor,
+                                   PayloadHeader *header)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Single pass straight into the signal table's staging area
+    PayloadDecoder::Format wireFormat = cbor ? PayloadDecoder::Cbor : PayloadDecoder::Json;
+    if (!decoder.decode(data, std::size_t(size), wireFormat, table, *header)) {
+        table.discard();
+        return false;
+    }
+
+    FormatStats &format = cbor ? formatStats.cbor : formatStats.json;
+    ++format.payloads;
+    format.bytes += size;
+    format.decodeNs += timer.nsecsElapsed();
+    emit decodeStatsChanged();
+    return true;
+}
+
+void NetworkManager::decodeLatest(const PayloadHeader &header)
+{
+    if (acceptDelta(header)) {
+        table.commit();
+        emit dataReceived(table);
+    }
+}
+
+void NetworkManager::decodeStatus(const PayloadHeader &header)
+{
+    if (header.hasStatus) {
+        emit systemStatusReceived(header.status);
+    }
+}
+
+void NetworkManager::decodeSnapshot(const PayloadHeader &header)
+{
+    decodeLatest(header);
+    decodeStatus(header);
+}
+
+const SignalTable &NetworkManager::signalTable() const
+{
+    return table;
+}
+
+void NetworkManager::setDeltaHeaders(QNetworkRequest &request) const
+{
+    // The server answers with only the messages changed after this point,
+    // or with everything if it does not recognise the epoch
+    request.setRawHeader("X-Since-Seq", QByteArray::number(deltaSequence));
+    request.setRawHeader("X-Since-Epoch", deltaEpoch);
+}
+
+bool NetworkManager::acceptDelta(const PayloadHeader &header)
+{
+    if (!header.hasSeq) {
+        return true;  // Server without delta support, always full
+    }
+
+    quint64 seq = header.seq;
+    quint64 since = header.since;
+    QByteArray epoch = QByteArray::fromRawData(header.epoch, qsizetype(header.epochLength));
+    bool full = header.full;
+
+    if (full) {
+        if (epoch == deltaEpoch && seq < deltaSequence) {
+            ++stats.late;  // Older than what we already hold
+            emit requestStatsChanged();
+            return false;
+        }
+    } else if (epoch != deltaEpoch || since > deltaSequence) {
+        // Built on a base we never applied: changes in between are
+        // missing, so start over with a full reply
+        deltaSequence = 0;
+        deltaEpoch.clear();
+        ++stats.resyncs;
+        emit requestStatsChanged();
+        return false;
+    } else if (seq < deltaSequence) {
+        ++stats.late;
+        emit requestStatsChanged();
+        return false;
+    }
+
+    // A delta from an older base is a superset of what we missed, so it
+    // is safe to apply as long as it ends at or after our position
+    deltaSequence = seq;
+    if (deltaEpoch != epoch) {
+        deltaEpoch = QByteArray(epoch.constData(), epoch.size());
+    }
+    return true;
+}
+
+void NetworkManager::startStream()
+{
+    if (local) {
+        local->connectToServer();
+        return;
+    }
+    if (shared) {
+        // Nothing is pushed: the segment is polled, so only (re)attach
+        if (!shared->isAttached() && shared->attach(sharedName.constData())) {
+            sharedIdle.start();
+        }
+        return;
+    }
+    if (can) {
+        if (can->isOpen()) {
+            return;
+        }
+        if (!can->open()) {
+            emit error(can->errorString());
+            return;
+        }
+        canUptime.start();
+        canFrames = 0;
+        canStatusTimer->start();
+        setStreaming(true);
+        return;
+    }
+    if (streamReply) {
+        return;
+    }
+
+    QNetworkRequest request(baseUrl.resolved(QUrl("can/stream")));
+    request.setRawHeader("Accept", "text/event-stream");
+    request.setRawHeader("Cache-Control", "no-cache");
+    setDeltaHeaders(request);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
+                         QNetworkRequest::AlwaysNetwork);
+
+    streamBuffer.clear();
+    streamCarriageReturn = false;
+    streamReply = manager->get(request);
+    connect(streamReply, &QNetworkReply::readyRead,
+            this, &NetworkManager::handleStreamReadyRead);
+    connect(streamReply, &QNetworkReply::finished,
+            this, &NetworkManager::handleStreamFinished);
+    streamWatchdog->start();
+}
+
+void NetworkManager::stopStream()
+{
+    streamWatchdog->stop();
+    if (local) {
+        local->abort();
+    }
+    if (can) {
+        can->close();
+        canStatusTimer->stop();
+    }
+    if (streamReply) {
+        streamReply->abort();  // Emits finished, which cleans up
+    }
+    setStreaming(false);
+}
+
+bool NetworkManager::isStreaming() const
+{
+    return m_streaming;
+}
+
+void NetworkManager::handleStreamReadyRead()
+{
+    QNetworkReply *reply = streamReply;
+    if (!reply) {
+        return;
+    }
+
+    if (!m_streaming) {
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        QByteArray type = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+        if (status != 200 || !type.startsWith("text/event-stream")) {
+            reply->abort();
+            return;
+        }
+        setStreaming(true);
+    }
+
+    streamWatchdog->start();
     
-    // Determine which type of response this is based on the URL
-    QString path = reply->url().path();
-    if (path.contains("/latest")) {
-        emit dataReceived(json);
-    } else if (path.contains("/status")) {
-        emit systemStatusReceived(json);
+    // Appended in place; the buffer keeps its capacity from read to read
+    qsizetype buffered = streamBuffer.size();
+    qint64 available = reply->bytesAvailable();
+    streamBuffer.resize(buffered + qsizetype(available));
+    qint64 read = reply->read(streamBuffer.data() + buffered, available);
+    read = qMax<qint64>(read, 0);
+
+    // Lines may end in CRLF, LF or CR; turn them all into LF where they
+    // were read, so a blank line is always "\n\n"
+    char *out = streamBuffer.data() + buffered;
+    for (const char *in = out, *end = in + read; in != end; ++in) {
+        if (*in == '\n' && streamCarriageReturn) {
+            streamCarriageReturn = false;
+            continue;
+        }
+        streamCarriageReturn = *in == '\r';
+        *out++ = streamCarriageReturn ? '\n' : *in;
     }
+    streamBuffer.resize(out - streamBuffer.constData());
+
+    // Events are separated by a blank line; keep any partial event buffered
+    qsizetype start = 0;
+    for (;;) {
+        qsizetype end = streamBuffer.indexOf("\n\n", start);
+        if (end < 0) {
+            break;
+        }
+        dispatchStreamEvent(QByteArrayView(streamBuffer.constData() + start, end - start));
+        start = end + 2;
+    }
+    if (start > 0) {
+        qsizetype rest = streamBuffer.size() - start;
+        std::memmove(streamBuffer.data(), streamBuffer.constData() + start, size_t(rest));
+        streamBuffer.resize(rest);
+    }
+}
+
+void NetworkManager::handleStreamFinished()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (reply) {
+        reply->deleteLater();
+    }
+
+    streamReply = nullptr;
+    streamWatchdog->stop();
+    streamBuffer.clear();
+    streamCarriageReturn = false;
+    setStreaming(false);
+}
+
+void NetworkManager::dispatchStreamEvent(QByteArrayView event)
+{
+    // Lines are views into the stream buffer; only the data lines are
+    // copied, joined in streamData, which keeps its capacity
+    QByteArrayView name("message");
+    streamData.resize(0);
+
+    while (!event.isEmpty()) {
+        qsizetype end = event.indexOf('\n');
+        QByteArrayView line = end < 0 ? event : event.first(end);
+        event = end < 0 ? QByteArrayView() : event.sliced(end + 1);
+        if (line.startsWith("event:")) {
+            name = line.sliced(6).trimmed();
+        } else if (line.startsWith("data:")) {
+            if (!streamData.isEmpty()) {
+                streamData.append('\n');
+            }
+            streamData.append(line.sliced(5).trimmed());
+        }
+        // Lines starting with ':' are keepalive comments
+    }
+
+    if (streamData.isEmpty()) {
+        return;
+    }
+
+    // SSE is a text protocol, so stream events are always JSON
+    PayloadHeader header;
+    if (!decodePayload(streamData.constData(), streamData.size(), false, &header)) {
+        emit error("Invalid JSON in stream event");
+        return;
+    }
+
+    if (name == "latest") {
+        decodeLatest(header);
+    } else if (name == "status") {
+        decodeStatus(header);
+    }
+    table.discard();
+}
+
+void NetworkManager::setStreaming(bool active)
+{
+    if (m_streaming == active) {
+        return;
+    }
+
+    m_streaming = active;
+    emit streamStateChanged(active);
+}
+
+void NetworkManager::sendLocalRequest(LocalTransport::FrameKind kind)
+{
+    if (!local->isConnected()) {
+        ++stats.dropped;  // Reconnects through startStream()
+        emit requestStatsChanged();
+        return;
+    }
+    local->sendRequest(kind, deltaSequence, deltaEpoch);
+    ++stats.sent;
+    emit requestStatsChanged();
+}
+
+void NetworkManager::handleLocalConnected()
+{
+    // Subscribe to pushed deltas; the connection is the stream
+    local->sendRequest(LocalTransport::Watch, deltaSequence, deltaEpoch);
+    streamWatchdog->start();
+    setStreaming(true);
+}
+
+void NetworkManager::handleLocalDisconnected()
+{
+    streamWatchdog->stop();
+    setStreaming(false);
+}
+
+void NetworkManager::handleLocalFrame(char kind, bool cbor, const char *data, qsizetype size)
+{
+    streamWatchdog->start();
+    if (kind == LocalTransport::Keepalive) {
+        return;
+    }
+
+    PayloadHeader header;
+    if (!decodePayload(data, size, cbor, &header)) {
+        emit error("Invalid payload on local socket");
+        return;
+    }
+
+    if (kind == LocalTransport::Latest) {
+        decodeLatest(header);
+    } else if (kind == LocalTransport::Status) {
+        decodeStatus(header);
+    } else if (kind == LocalTransport::Snapshot) {
+        decodeSnapshot(header);
+    }
+    table.discard();
+}
+
+void NetworkManager::readSharedMemory()
+{
+    if (!shared->isAttached()) {
+        if (!shared->attach(sharedName.constData())) {
+            ++stats.dropped;  // Writer not running yet
+            emit requestStatsChanged();
+            return;
+        }
+        sharedIdle.start();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    ++stats.sent;
+    SystemStatus status;
+    bool statusUpdated = false;
+    ShmSnapshotReader::Result result = shared->read(table, status, statusUpdated);
+    stats.roundTripNs = timer.nsecsElapsed();
+    switch (result) {
+    case ShmSnapshotReader::Updated:
+        ++stats.completed;
+        sharedIdle.restart();
+        table.commit();
+        emit dataReceived(table);
+        if (statusUpdated) {
+            emit systemStatusReceived(status);
+        }
+        break;
+    case ShmSnapshotReader::Unchanged:
+        ++stats.completed;
+        // A writer that crashed and restarted publishes a new segment
+        // under the same name; the old mapping just goes quiet
+        if (sharedIdle.elapsed() > SHARED_IDLE_TIMEOUT_MS) {
+            shared->detach();
+        }
+        break;
+    case ShmSnapshotReader::Busy:
+        ++stats.dropped;  // Picked up on the next tick
+        break;
+    case ShmSnapshotReader::Detached:
+        shared->detach();
+        ++stats.dropped;
+        break;
+    }
+    emit requestStatsChanged();
+}
+
+void NetworkManager::handleCanFrames(const can_frame *frames, int count)
+{
+    // The whole batch is staged and committed once, so the ingest worker
+    // takes its lock and wakes the GUI once per batch, not per frame
+    // Stamped on the monotonic clock the rest of the client measures
+    // arrivals with, so a wall-clock step cannot make samples look old
+    qint64 timestamp = PollScheduler::now() / 1000000;
+    bool decoded = false;
+    for (int i = 0; i < count; ++i) {
+        const can_frame &frame = frames[i];
+        CanDecoder::Result result = canDecoder.decode(frame.can_id, frame.data,
+                                                      qMin<int>(frame.can_dlc, CAN_MAX_DLEN),
+                                                      timestamp, table);
+        if (result == CanDecoder::Malformed) {
+            ++canErrors;
+        } else if (result == CanDecoder::Decoded) {
+            decoded = true;
+        }
+    }
+    canFrames += quint64(count);
+
+    if (decoded) {
+        table.commit();
+        emit dataReceived(table);
+    }
+}
+
+void NetworkManager::handleCanClosed()
+{
+    emit error(can->errorString());
+    canStatusTimer->stop();
+    publishCanStatus();
+    setStreaming(false);
+}
+
+void NetworkManager::publishCanStatus()
+{
+    SystemStatus status;
+    status.connected = can->isOpen() && canFrames > 0;  // A live bus is never silent
+    status.uptime = can->isOpen() ? canUptime.elapsed() / 1000 : 0;
+    status.messageRate = double(canFrames) * 1000.0 / canStatusTimer->interval();
+    status.errorCount = canErrors;
+    canFrames = 0;
+    emit systemStatusReceived(status);
 }
\ No newline at end of file
@@ -4,28 +4,153 @@
 #include <QtCore/QObject>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkReply>
-#include <QtCore/QJsonObject>
+#include <QtNetwork/QNetworkRequest>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+#include <QtCore/QPointer>
+#include <QtCore/QTimer>
 #include <QtCore/QUrl>
+#include "candecoder.h"
+#include "cansocket.h"
+#include "localtransport.h"
+#include "payloaddecoder.h"
+#include "shmsnapshot.h"
+#include "signaltable.h"
 
 class NetworkManager : public QObject {
     Q_OBJECT
     
 public:
-    explicit NetworkManager(QObject *parent = nullptr);
+    // Outcome counters for polled requests
+    struct RequestStats {
+        quint64 sent = 0;
+        quint64 completed = 0;
+        quint64 dropped = 0;    // Not sent: a request was already outstanding
+        quint64 cancelled = 0;  // Aborted: superseded or replaced by the stream
+        quint64 late = 0;       // Server sequence behind the state already applied
+        quint64 resyncs = 0;    // Delta did not continue from our sequence
+        qint64 roundTripNs = 0; // Of the latest completed poll
+    };
     
-    void fetchLatestData();
-    void fetchSystemStatus();
+    // Wire size and parse cost per payload format
+    struct FormatStats {
+        quint64 payloads = 0;
+        quint64 bytes = 0;
+        qint64 decodeNs = 0;
+    };
+    struct DecodeStats {
+        FormatStats json;
+        FormatStats cbor;
+    };
+    
+    // http(s)://host/api/v1/, unix:/path/to/socket, shm:/segment-name or
+    // can:interface for frames read straight off the bus
+    explicit NetworkManager(const QUrl &serverUrl, QObject *parent = nullptr);
+    ~NetworkManager();
+    
+    static QUrl defaultServerUrl();
+    
+    // Interval between fetchSnapshot() calls while idle and not streaming
+    int pollInterval() const;
+    
+    // Latest values and status in one round trip (can/snapshot)
+    void fetchSnapshot();
+    
+    // Server-Sent Events push stream (can/stream)
+    void startStream();
+    void stopStream();
+    bool isStreaming() const;
+    
+    RequestStats requestStats() const;
+    DecodeStats decodeStats() const;
+    const SignalTable &signalTable() const;
+    void cancelPendingRequests();
     
 signals:
-    void dataReceived(const QJsonObject &data);
-    void systemStatusReceived(const QJsonObject &status);
+    // `table` holds every signal; table.changed() lists what this update changed
+    void dataReceived(const SignalTable &table);
+    void systemStatusReceived(const SystemStatus &status);
+    void streamStateChanged(bool active);
+    void requestStatsChanged();
+    void decodeStatsChanged();
     void error(const QString &message);
     
 private:
     QNetworkAccessManager *manager;
     QUrl baseUrl;
+    LocalTransport *local;  // Set when the server URL is unix:
+    ShmSnapshotReader *shared;  // Set when the server URL is shm:
+    QByteArray sharedName;
+    QElapsedTimer sharedIdle;
+    CanSocket *can;  // Set when the server URL is can:
+    CanDecoder canDecoder;
+    QTimer *canStatusTimer;
+    QElapsedTimer canUptime;
+    quint64 canFrames;  // Since the last status update
+    qint64 canErrors;
+    
+    // Picked when the request is sent, so replies need no URL matching
+    using ReplyDecoder = void (NetworkManager::*)(const PayloadHeader &header);
+    
+    // Built once in the constructor and reused for every poll
+    struct Endpoint {
+        QNetworkRequest request;
+        ReplyDecoder decoder;
+        bool delta = false;  // Sends X-Since-Seq and may get a partial reply
+    };
+    
+    struct PendingRequest {
+        QNetworkReply *reply;
+        Endpoint *endpoint;
+        QElapsedTimer age;
+    };
+    
+    Endpoint snapshotEndpoint;
+    
+    QList<PendingRequest> inFlight;  // At most one per endpoint
+    RequestStats stats;
+    
+    // Server data sequence of the last applied can/latest state
+    quint64 deltaSequence;
+    QByteArray deltaEpoch;
+    
+    SignalTable table;
+    PayloadDecoder decoder;
+    DecodeStats formatStats;
+    
+    QPointer<QNetworkReply> streamReply;
+    QTimer *streamWatchdog;
+    QByteArray streamBuffer;
+    QByteArray streamData;     // Data lines of the event being dispatched
+    QByteArray receiveBuffer;  // Body of the polled reply being decoded
+    bool m_streaming;
+    bool streamCarriageReturn;  // The last byte read was a CR, whose LF may follow
+    
+    static const int REQUEST_TIMEOUT_MS = 500;  // Data older than this is stale
+    static const int SHARED_IDLE_TIMEOUT_MS = 2500;
     
+    Endpoint makeEndpoint(const char *path, ReplyDecoder decoder, bool delta) const;
+    void sendRequest(Endpoint &endpoint);
+    void abortRequest(qsizetype index);
     void handleNetworkReply(QNetworkReply *reply);
+    bool decodePayload(const char *data, qsizetype size, bool cbor, PayloadHeader *header);
+    void decodeLatest(const PayloadHeader &header);
+    void decodeStatus(const PayloadHeader &header);
+    void decodeSnapshot(const PayloadHeader &header);
+    void setDeltaHeaders(QNetworkRequest &request) const;
+    bool acceptDelta(const PayloadHeader &header);
+    void handleStreamReadyRead();
+    void handleStreamFinished();
+    void dispatchStreamEvent(QByteArrayView event);
+    void setStreaming(bool active);
+    void sendLocalRequest(LocalTransport::FrameKind kind);
+    void handleLocalConnected();
+    void handleLocalDisconnected();
+    void handleLocalFrame(char kind, bool cbor, const char *data, qsizetype size);
+    void readSharedMemory();
+    void handleCanFrames(const can_frame *frames, int count);
+    void handleCanClosed();
+    void publishCanStatus();
 };
 
 #endif // NETWORKMANAGER_H
\ No newline at end of file
@@ -0,0 +1,620 @@
+#include "payloaddecoder.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const int MAX_DEPTH = 32;
+
+template <std::size_t N>
+bool keyIs(const char *key, std::size_t length, const char (&literal)[N])
+{
+    return length == N - 1 && std::memcmp(key, literal, N - 1) == 0;
+}
+
+// Pull reader over JSON text. Keys and strings are returned as pointers
+// into the input; escapes are left as-is, which is fine because none of
+// the keys we match contain any.
+class JsonReader {
+public:
+    JsonReader(const char *data, std::size_t size)
+        : p(data)
+        , end(data + size)
+        , depth(0)
+        , error(false)
+    {
+    }
+
+    bool beginObject()
+    {
+        skipSpace();
+        if (p == end || *p != '{' || depth == MAX_DEPTH) {
+            return fail();
+        }
+        ++p;
+        first[depth++] = true;
+        return true;
+    }
+
+    // False once the object is exhausted (or on error)
+    bool nextKey(const char *&key, std::size_t &length)
+    {
+        skipSpace();
+        if (p == end) {
+            return fail();
+        }
+        if (*p == '}') {
+            ++p;
+            --depth;
+            return false;
+        }
+        if (!first[depth - 1]) {
+            if (*p != ',') {
+                return fail();
+            }
+            ++p;
+            skipSpace();
+        }
+        first[depth - 1] = false;
+        if (!readString(key, length)) {
+            return fail();
+        }
+        skipSpace();
+        if (p == end || *p != ':') {
+            return fail();
+        }
+        ++p;
+        return true;
+    }
+
+    bool readNumber(double &value)
+    {
+        skipSpace();
+        if (p != end && (*p == '-' || (*p >= '0' && *p <= '9'))) {
+            std::from_chars_result result = std::from_chars(p, end, value);
+            if (result.ec != std::errc()) {
+                return fail();
+            }
+            p = result.ptr;
+            return true;
+        }
+        skipValue();
+        return false;
+    }
+
+    bool readBool(bool &value)
+    {
+        skipSpace();
+        if (matchLiteral("true")) {
+            value = true;
+            return true;
+        }
+        if (matchLiteral("false")) {
+            value = false;
+            return true;
+        }
+        skipValue();
+        return false;
+    }
+
+    bool readString(const char *&text, std::size_t &length)
+    {
+        skipSpace();
+        if (p == end || *p != '"') {
+            skipValue();
+            return false;
+        }
+        const char *start = ++p;
+        while (p != end && *p != '"') {
+            if (*p == '\\' && ++p == end) {
+                break;
+            }
+            ++p;
+        }
+        if (p == end) {
+            return fail();
+        }
+        text = start;
+        length = std::size_t(p - start);
+        ++p;
+        return true;
+    }
+
+    bool skipValue()
+    {
+        skipSpace();
+        if (p == end) {
+            return fail();
+        }
+        switch (*p) {
+        case '{':
+        case '[':
+            return skipContainer();
+        case '"': {
+            const char *text;
+            std::size_t length;
+            return readString(text, length);
+        }
+        case 't':
+            return matchLiteral("true") || fail();
+        case 'f':
+            return matchLiteral("false") || fail();
+        case 'n':
+            return matchLiteral("null") || fail();
+        default: {
+            const char *start = p;
+            while (p != end && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+'
+                                || *p == '.' || *p == 'e' || *p == 'E')) {
+                ++p;
+            }
+            return p != start || fail();
+        }
+        }
+    }
+
+    bool finish()
+    {
+        skipSpace();
+        return !error && depth == 0 && p == end;
+    }
+
+    bool failed() const
+    {
+        return error;
+    }
+
+private:
+    const char *p;
+    const char *end;
+    bool first[MAX_DEPTH];
+    int depth;
+    bool error;
+
+    bool fail()
+    {
+        error = true;
+        p = end;
+        return false;
+    }
+
+    void skipSpace()
+    {
+        while (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+            ++p;
+        }
+    }
+
+    template <std::size_t N>
+    bool matchLiteral(const char (&literal)[N])
+    {
+        if (std::size_t(end - p) >= N - 1 && std::memcmp(p, literal, N - 1) == 0) {
+            p += N - 1;
+            return true;
+        }
+        return false;
+    }
+
+    bool skipContainer()
+    {
+        int nesting = 0;
+        do {
+            if (*p == '"') {
+                const char *text;
+                std::size_t length;
+                if (!readString(text, length)) {
+                    return false;
+                }
+                continue;
+            }
+            if (*p == '{' || *p == '[') {
+                ++nesting;
+            } else if (*p == '}' || *p == ']') {
+                --nesting;
+            }
+            ++p;
+        } while (nesting > 0 && p != end);
+        return nesting == 0 || fail();
+    }
+};
+
+// Pull reader over RFC 8949 CBOR with the same interface as JsonReader
+class CborReader {
+public:
+    CborReader(const char *data, std::size_t size)
+        : p(reinterpret_cast<const std::uint8_t *>(data))
+        , end(p + size)
+        , depth(0)
+        , error(false)
+    {
+    }
+
+    bool beginObject()
+    {
+        std::uint8_t major;
+        std::uint64_t count;
+        bool indefinite;
+        if (depth == MAX_DEPTH || !readHead(major, count, indefinite) || major != 5) {
+            return fail();
+        }
+        remaining[depth++] = indefinite ? -1 : std::int64_t(count);
+        return true;
+    }
+
+    bool nextKey(const char *&key, std::size_t &length)
+    {
+        std::int64_t &left = remaining[depth - 1];
+        if (left == 0 || (left < 0 && p != end && *p == 0xff)) {
+            if (left < 0) {
+                ++p;
+            }
+            --depth;
+            return false;
+        }
+        if (p == end) {
+            return fail();
+        }
+        if (left > 0) {
+            --left;
+        }
+        if (!readString(key, length)) {
+            // Non-text key: nothing we know, let the caller skip the value
+            key = nullptr;
+            length = 0;
+        }
+        return !error;
+    }
+
+    bool readNumber(double &value)
+    {
+        if (p == end) {
+            return fail();
+        }
+        std::uint8_t initial = *p;
+        std::uint8_t major = initial >> 5;
+        if (major == 0 || major == 1) {
+            std::uint64_t argument;
+            bool indefinite;
+            if (!readHead(major, argument, indefinite)) {
+                return false;
+            }
+            value = major == 0 ? double(argument) : -1.0 - double(argument);
+            return !error;
+        }
+        if (initial == 0xf9 && end - p >= 3) {
+            value = halfToDouble(std::uint16_t(p[1] << 8 | p[2]));
+            p += 3;
+            return true;
+        }
+        if (initial == 0xfa && end - p >= 5) {
+            std::uint32_t bits = readBigEndian(p + 1, 4);
+            float single;
+            std::memcpy(&single, &bits, sizeof(single));
+            value = single;
+            p += 5;
+            return true;
+        }
+        if (initial == 0xfb && end - p >= 9) {
+            std::uint64_t bits = readBigEndian(p + 1, 8);
+            std::memcpy(&value, &bits, sizeof(value));
+            p += 9;
+            return true;
+        }
+        skipValue();
+        return false;
+    }
+
+    bool readBool(bool &value)
+    {
+        if (p != end && (*p == 0xf4 || *p == 0xf5)) {
+            value = *p++ == 0xf5;
+            return true;
+        }
+        skipValue();
+        return false;
+    }
+
+    bool readString(const char *&text, std::size_t &length)
+    {
+        if (p == end || (*p >> 5) != 3 || (*p & 0x1f) == 31) {
+            skipValue();
+            return false;
+        }
+        std::uint8_t major;
+        std::uint64_t count;
+        bool indefinite;
+        if (!readHead(major, count, indefinite) || count > std::uint64_t(end - p)) {
+            return fail();
+        }
+        text = reinterpret_cast<const char *>(p);
+        length = std::size_t(count);
+        p += count;
+        return true;
+    }
+
+    bool skipValue()
+    {
+        return skipItem(0);
+    }
+
+    bool finish()
+    {
+        return !error && depth == 0 && p == end;
+    }
+
+    bool failed() const
+    {
+        return error;
+    }
+
+private:
+    const std::uint8_t *p;
+    const std::uint8_t *end;
+    std::int64_t remaining[MAX_DEPTH];  // Entries left per open map, -1 = indefinite
+    int depth;
+    bool error;
+
+    bool fail()
+    {
+        error = true;
+        p = end;
+        return false;
+    }
+
+    static std::uint64_t readBigEndian(const std::uint8_t *bytes, int count)
+    {
+        std::uint64_t value = 0;
+        for (int i = 0; i < count; ++i) {
+            value = value << 8 | bytes[i];
+        }
+        return value;
+    }
+
+    static double halfToDouble(std::uint16_t half)
+    {
+        int exponent = (half >> 10) & 0x1f;
+        int mantissa = half & 0x3ff;
+        double value;
+        if (exponent == 0) {
+            value = std::ldexp(mantissa, -24);
+        } else if (exponent != 31) {
+            value = std::ldexp(mantissa + 1024, exponent - 25);
+        } else {
+            value = mantissa == 0 ? INFINITY : NAN;
+        }
+        return (half & 0x8000) ? -value : value;
+    }
+
+    bool readHead(std::uint8_t &major, std::uint64_t &argument, bool &indefinite)
+    {
+        if (p == end) {
+            return fail();
+        }
+        major = *p >> 5;
+        std::uint8_t info = *p & 0x1f;
+        ++p;
+        indefinite = false;
+        if (info < 24) {
+            argument = info;
+            return true;
+        }
+        if (info == 31) {
+            indefinite = true;
+            argument = 0;
+            return true;
+        }
+        if (info > 27) {
+            return fail();
+        }
+        int bytes = 1 << (info - 24);
+        if (end - p < bytes) {
+            return fail();
+        }
+        argument = readBigEndian(p, bytes);
+        p += bytes;
+        return true;
+    }
+
+    bool skipItem(int nesting)
+    {
+        if (nesting > MAX_DEPTH) {
+            return fail();
+        }
+        std::uint8_t major;
+        std::uint64_t argument;
+        bool indefinite;
+        if (!readHead(major, argument, indefinite)) {
+            return false;
+        }
+        switch (major) {
+        case 0:
+        case 1:
+            return true;
+        case 2:
+        case 3:
+            if (indefinite) {
+                return skipUntilBreak(nesting);
+            }
+            if (argument > std::uint64_t(end - p)) {
+                return fail();
+            }
+            p += argument;
+            return true;
+        case 4:
+        case 5: {
+            if (indefinite) {
+                return skipUntilBreak(nesting);
+            }
+            std::uint64_t items = major == 5 ? argument * 2 : argument;
+            for (std::uint64_t i = 0; i < items; ++i) {
+                if (!skipItem(nesting + 1)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case 6:
+            return skipItem(nesting + 1);
+        default:
+            // Simple values and floats: readHead already consumed them
+            return !indefinite || fail();
+        }
+    }
+
+    bool skipUntilBreak(int nesting)
+    {
+        while (p != end && *p != 0xff) {
+            if (!skipItem(nesting + 1)) {
+                return false;
+            }
+        }
+        if (p == end) {
+            return fail();
+        }
+        ++p;
+        return true;
+    }
+};
+
+template <typename Reader>
+class PayloadWalker {
+public:
+    PayloadWalker(Reader &reader, const SignalSchema &schema,
+                  SignalTable &table, PayloadHeader &header)
+        : reader(reader)
+        , schema(schema)
+        , table(table)
+        , header(header)
+    {
+    }
+
+    bool run()
+    {
+        return walkHeader() && reader.finish();
+    }
+
+private:
+    Reader &reader;
+    const SignalSchema &schema;
+    SignalTable &table;
+    PayloadHeader &header;
+
+    // The root of can/latest and can/status, and the "latest" and
+    // "status" members of can/snapshot; their key sets do not overlap
+    bool walkHeader()
+    {
+        if (!reader.beginObject()) {
+            return false;
+        }
+        const char *key;
+        std::size_t length;
+        double number;
+        while (reader.nextKey(key, length)) {
+            if (keyIs(key, length, "messages")) {
+                if (!walkMessages()) {
+                    return false;
+                }
+            } else if (keyIs(key, length, "latest") || keyIs(key, length, "status")) {
+                if (!walkHeader()) {
+                    return false;
+                }
+            } else if (keyIs(key, length, "seq")) {
+                if (reader.readNumber(number)) {
+                    header.hasSeq = true;
+                    header.seq = std::uint64_t(number);
+                }
+            } else if (keyIs(key, length, "since")) {
+                if (reader.readNumber(number)) {
+                    header.since = std::uint64_t(number);
+                }
+            } else if (keyIs(key, length, "full")) {
+                reader.readBool(header.full);
+            } else if (keyIs(key, length, "epoch")) {
+                const char *text;
+                std::size_t textLength;
+                if (reader.readString(text, textLength)) {
+                    header.epochLength = std::min(textLength, sizeof(header.epoch));
+                    std::memcpy(header.epoch, text, header.epochLength);
+                }
+            } else if (keyIs(key, length, "connected")) {
+                header.hasStatus = true;
+                reader.readBool(header.status.connected);
+            } else if (keyIs(key, length, "uptime")) {
+                if (reader.readNumber(number)) {
+                    header.status.uptime = std::int64_t(number);
+                }
+            } else if (keyIs(key, length, "message_rate")) {
+                reader.readNumber(header.status.messageRate);
+            } else if (keyIs(key, length, "error_count")) {
+                if (reader.readNumber(number)) {
+                    header.status.errorCount = std::int64_t(number);
+                }
+            } else {
+                reader.skipValue();
+            }
+        }
+        return !reader.failed();
+    }
+
+    bool walkMessages()
+    {
+        if (!reader.beginObject()) {
+            return false;
+        }
+        const char *key;
+        std::size_t length;
+        while (reader.nextKey(key, length)) {
+            int index = key ? schema.indexOf(key, length) : -1;
+            if (index < 0) {
+                reader.skipValue();
+            } else if (!walkMessage(table.stage(index))) {
+                return false;
+            }
+        }
+        return !reader.failed();
+    }
+
+    bool walkMessage(SignalSample &sample)
+    {
+        if (!reader.beginObject()) {
+            return false;
+        }
+        const char *key;
+        std::size_t length;
+        double number;
+        while (reader.nextKey(key, length)) {
+            if (keyIs(key, length, "value")) {
+                // null or a non-number means the source has no valid value
+                sample.valid = reader.readNumber(sample.value);
+            } else if (keyIs(key, length, "timestamp")) {
+                if (reader.readNumber(number)) {
+                    sample.timestamp = std::int64_t(number);
+                }
+            } else if (keyIs(key, length, "is_stale")) {
+                reader.readBool(sample.stale);
+            } else {
+                reader.skipValue();
+            }
+        }
+        return !reader.failed();
+    }
+};
+
+} // namespace
+
+PayloadDecoder::PayloadDecoder(const SignalSchema &schema)
+    : schema(schema)
+{
+}
+
+bool PayloadDecoder::decode(const char *data, std::size_t size, Format format,
+                            SignalTable &table, PayloadHeader &header) const
+{
+    if (format == Cbor) {
+        CborReader reader(data, size);
+        return PayloadWalker<CborReader>(reader, schema, table, header).run();
+    }
+    JsonReader reader(data, size);
+    return PayloadWalker<JsonReader>(reader, schema, table, header).run();
+}
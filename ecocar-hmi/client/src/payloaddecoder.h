@@ -0,0 +1,51 @@
+#ifndef PAYLOADDECODER_H
+#define PAYLOADDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "signaltable.h"
+
+struct SystemStatus {
+    bool connected = false;
+    std::int64_t uptime = 0;
+    double messageRate = 0.0;
+    std::int64_t errorCount = 0;
+};
+
+// Everything in a payload that is not a signal value
+struct PayloadHeader {
+    bool hasSeq = false;
+    std::uint64_t seq = 0;
+    std::uint64_t since = 0;
+    bool full = false;
+    char epoch[32] = {};
+    std::size_t epochLength = 0;
+
+    bool hasStatus = false;
+    SystemStatus status;
+};
+
+// Decodes can/latest, can/status and can/snapshot payloads (and the
+// equivalent stream events) in a single pass over the raw bytes. Signal
+// values go straight into the staging area of a SignalTable, found by the
+// schema's hashed key lookup; no document tree or string is built and
+// nothing is allocated. Unknown keys are skipped.
+class PayloadDecoder {
+public:
+    enum Format {
+        Json,
+        Cbor
+    };
+
+    explicit PayloadDecoder(const SignalSchema &schema);
+
+    // Stages decoded samples into `table` and fills `header`. The caller
+    // commits or discards the table afterwards.
+    bool decode(const char *data, std::size_t size, Format format,
+                SignalTable &table, PayloadHeader &header) const;
+
+private:
+    const SignalSchema &schema;
+};
+
+#endif // PAYLOADDECODER_H
@@ -0,0 +1,129 @@
+#include "pollscheduler.h"
+#include <algorithm>
+#include <chrono>
+
+PollScheduler::PollScheduler()
+    : lastSwap(0)
+    , period(DEFAULT_FRAME_NS)
+    , m_mode(Idle)
+    , idleInterval(100000000)  // POLLING_INTERVAL_MS
+    , roundTrip(0)
+    , lastTarget(0)
+{
+}
+
+std::int64_t PollScheduler::now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void PollScheduler::frameSwapped(std::int64_t swapNs)
+{
+    std::int64_t previous = lastSwap.exchange(swapNs, std::memory_order_acq_rel);
+    if (previous == 0) {
+        return;
+    }
+
+    // Only back-to-back frames say anything about the refresh period;
+    // the scene graph stops rendering while nothing changes
+    std::int64_t current = period.load(std::memory_order_relaxed);
+    std::int64_t delta = swapNs - previous;
+    if (delta > current / 2 && delta < current + current / 2) {
+        period.store(current + (delta - current) / 16, std::memory_order_relaxed);
+    }
+
+    // Only this thread writes the frame counters
+    if (delta > 0 && delta < IDLE_GAP_NS) {
+        frameCounters.frames.fetch_add(1, std::memory_order_relaxed);
+        frameCounters.totalNs.fetch_add(delta, std::memory_order_relaxed);
+        if (delta >= current + current / 2) {
+            frameCounters.missed.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (delta > frameCounters.maxNs.load(std::memory_order_relaxed)) {
+            frameCounters.maxNs.store(delta, std::memory_order_relaxed);
+        }
+    }
+}
+
+void PollScheduler::recordPhotonLatency(std::int64_t latencyNs)
+{
+    LatencyCounters &counters = latencies[mode()];
+    counters.frames.fetch_add(1, std::memory_order_relaxed);
+    counters.totalNs.fetch_add(latencyNs, std::memory_order_relaxed);
+    std::int64_t max = counters.maxNs.load(std::memory_order_relaxed);
+    while (latencyNs > max
+           && !counters.maxNs.compare_exchange_weak(max, latencyNs, std::memory_order_relaxed)) {
+    }
+}
+
+void PollScheduler::setIdleInterval(std::int64_t intervalNs)
+{
+    idleInterval = intervalNs;
+}
+
+void PollScheduler::setMode(Mode mode)
+{
+    m_mode.store(mode, std::memory_order_relaxed);
+}
+
+void PollScheduler::fetchCompleted(std::int64_t roundTripNs)
+{
+    roundTrip += (roundTripNs - roundTrip) / 8;
+}
+
+std::int64_t PollScheduler::nextFetchDelay(std::int64_t nowNs)
+{
+    const std::int64_t frame = framePeriod();
+    const std::int64_t lead = roundTrip + MARGIN_NS;
+    const std::int64_t interval = mode() == Active ? frame : std::max(frame, idleInterval);
+
+    // Aim the reply at a swap: no sooner than it can arrive, and no sooner
+    // than one interval after the previous target
+    std::int64_t target = std::max(nowNs + lead, lastTarget + interval - frame / 2);
+    std::int64_t swap = lastSwap.load(std::memory_order_acquire);
+    if (swap != 0 && target > swap) {
+        // The vsync grid keeps going while the scene graph is idle
+        std::int64_t frames = (target - swap + frame - 1) / frame;
+        target = swap + frames * frame;
+    }
+    lastTarget = target;
+    return std::max<std::int64_t>(0, target - lead - nowNs);
+}
+
+void PollScheduler::setFramePeriod(std::int64_t periodNs)
+{
+    if (periodNs > 0) {
+        period.store(periodNs, std::memory_order_relaxed);
+    }
+}
+
+std::int64_t PollScheduler::framePeriod() const
+{
+    return period.load(std::memory_order_relaxed);
+}
+
+PollScheduler::Mode PollScheduler::mode() const
+{
+    return Mode(m_mode.load(std::memory_order_relaxed));
+}
+
+PollScheduler::LatencyStats PollScheduler::latency(Mode mode) const
+{
+    const LatencyCounters &counters = latencies[mode];
+    LatencyStats stats;
+    stats.frames = counters.frames.load(std::memory_order_relaxed);
+    stats.totalNs = counters.totalNs.load(std::memory_order_relaxed);
+    stats.maxNs = counters.maxNs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+PollScheduler::FrameStats PollScheduler::frameTimes() const
+{
+    FrameStats stats;
+    stats.frames = frameCounters.frames.load(std::memory_order_relaxed);
+    stats.missed = frameCounters.missed.load(std::memory_order_relaxed);
+    stats.totalNs = frameCounters.totalNs.load(std::memory_order_relaxed);
+    stats.maxNs = frameCounters.maxNs.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,92 @@
+#ifndef POLLSCHEDULER_H
+#define POLLSCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Times polls against the display's frame clock. The render thread reports
+// every frame swap; the ingest thread asks when to send the next fetch so
+// its reply, after the recent round trip, is applied just before a swap
+// rather than anywhere within the frame. Polls go out every frame while
+// the car is moving or a value is close to a warning level (Active), and
+// at the idle interval otherwise.
+//
+// Also keeps data-to-photon latency per mode: from the moment an update
+// reaches the client to the swap of the first frame synchronised after it,
+// and the frame time: the interval between back-to-back swaps.
+class PollScheduler {
+public:
+    enum Mode {
+        Idle,
+        Active,
+        ModeCount
+    };
+
+    struct LatencyStats {
+        std::uint64_t frames = 0;
+        std::int64_t totalNs = 0;
+        std::int64_t maxNs = 0;
+    };
+
+    // Intervals over a frame and a half missed at least one vsync
+    struct FrameStats {
+        std::uint64_t frames = 0;
+        std::uint64_t missed = 0;
+        std::int64_t totalNs = 0;
+        std::int64_t maxNs = 0;
+    };
+
+    PollScheduler();
+
+    // Monotonic clock every caller must use, in ns
+    static std::int64_t now();
+
+    // Render thread
+    void frameSwapped(std::int64_t swapNs);
+    void recordPhotonLatency(std::int64_t latencyNs);
+
+    // Ingest thread
+    void setIdleInterval(std::int64_t intervalNs);
+    void setMode(Mode mode);
+    void fetchCompleted(std::int64_t roundTripNs);
+    // Delay before sending the next fetch; call once per fetch
+    std::int64_t nextFetchDelay(std::int64_t nowNs);
+
+    // Any thread
+    void setFramePeriod(std::int64_t periodNs);
+    std::int64_t framePeriod() const;
+    Mode mode() const;
+    LatencyStats latency(Mode mode) const;
+    FrameStats frameTimes() const;
+
+private:
+    static const std::int64_t DEFAULT_FRAME_NS = 1000000000 / 60;  // TARGET_FPS
+    static const std::int64_t MARGIN_NS = 2000000;  // Decode, hand over and sync
+    static const std::int64_t IDLE_GAP_NS = 250000000;  // Longer: the scene graph was idle
+
+    struct LatencyCounters {
+        std::atomic<std::uint64_t> frames{0};
+        std::atomic<std::int64_t> totalNs{0};
+        std::atomic<std::int64_t> maxNs{0};
+    };
+
+    struct FrameCounters {
+        std::atomic<std::uint64_t> frames{0};
+        std::atomic<std::uint64_t> missed{0};
+        std::atomic<std::int64_t> totalNs{0};
+        std::atomic<std::int64_t> maxNs{0};
+    };
+
+    std::atomic<std::int64_t> lastSwap;
+    std::atomic<std::int64_t> period;
+    std::atomic<int> m_mode;
+    LatencyCounters latencies[ModeCount];
+    FrameCounters frameCounters;
+
+    // Ingest thread only
+    std::int64_t idleInterval;
+    std::int64_t roundTrip;
+    std::int64_t lastTarget;
+};
+
+#endif // POLLSCHEDULER_H
@@ -0,0 +1,54 @@
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Controls.Material
+import QtQuick.Layouts
+
+// Every signal the client knows about, one row each from dataModel.signalModel
+Item {
+    ListView {
+        anchors.fill: parent
+        clip: true
+        model: dataModel.signalModel
+
+        delegate: RowLayout {
+            required property string key
+            required property string unit
+            required property real value
+            required property bool valid
+            required property bool stale
+            required property int level
+
+            // Over the last minute; refreshed a couple of times a second
+            property var minute: ({})
+
+            width: ListView.view.width
+
+            Connections {
+                target: dataModel
+                function onStatisticsChanged() {
+                    minute = dataModel.statistics(key, "1m")
+                }
+            }
+
+            Label {
+                text: key
+                Layout.fillWidth: true
+                padding: 10
+            }
+            Label {
+                text: valid ? value.toFixed(2) + " " + unit : "--"
+                opacity: stale ? 0.5 : 1.0
+                color: level === 2 ? "#F44336" : level === 1 ? "#FFC107" : Material.foreground
+                padding: 10
+            }
+            // Minimum / mean / maximum
+            Label {
+                text: minute.count > 0
+                      ? minute.min.toFixed(1) + " / " + minute.mean.toFixed(1) + " / " + minute.max.toFixed(1)
+                      : ""
+                opacity: 0.7
+                padding: 10
+            }
+        }
+    }
+}
@@ -1,20 +1,33 @@
+import QtQuick
+
 Item {
+    id: card
+
     // Properties
     property string title: ""
     property var value
     property string unit: ""
-    property bool isWarning: false
-    property bool isError: false
-    property string warningThreshold: ""
-    property string errorThreshold: ""
+    property string key: ""  // Signal whose threshold level colours the card
     property string description: ""
+    readonly property int level: signalLevel.level
+    property bool isWarning: level === 1
+    property bool isError: level === 2
     
     // Style properties
     property color backgroundColor: "#424242"
     property color textColor: "#FFFFFF"
+    property color warningColor: "#FFC107"
+    property color errorColor: "#F44336"
     property real cornerRadius: 8
+    readonly property color levelColor: level === 2 ? errorColor : level === 1 ? warningColor : textColor
     
     // Signals
     signal clicked()
     signal thresholdExceeded(string level, var value)
+
+    SignalLevel {
+        id: signalLevel
+        key: card.key
+        onExceeded: (threshold, value) => card.thresholdExceeded(threshold, value)
+    }
 }
\ No newline at end of file
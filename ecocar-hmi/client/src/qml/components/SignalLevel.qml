@@ -0,0 +1,35 @@
+import QtQuick
+
+// Threshold level of one signal, for items that show a single signal
+// instead of being a delegate of dataModel.signalModel. Follows
+// DataModel's threshold transitions, so nothing runs on ordinary updates.
+QtObject {
+    id: signalLevel
+
+    property string key: ""
+    property int level: 0  // 0 normal, 1 warning, 2 error
+
+    // Rising edge into "warning" or "error"
+    signal exceeded(string threshold, real value)
+
+    function refresh() {
+        level = dataModel.signalModel.level(dataModel.signalModel.indexOf(key))
+    }
+
+    onKeyChanged: refresh()
+    Component.onCompleted: refresh()
+
+    property Connections thresholdConnections: Connections {
+        target: dataModel
+        function onThresholdChanged(changedKey, newLevel) {
+            if (changedKey === signalLevel.key) {
+                signalLevel.level = newLevel
+            }
+        }
+        function onThresholdExceeded(changedKey, value, threshold) {
+            if (changedKey === signalLevel.key) {
+                signalLevel.exceeded(threshold, value)
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -1,20 +1,37 @@
+import QtQuick
+
 Item {
+    id: gauge
+
     // Properties
     property real value: 0.0
     property real minValue: 0.0
     property real maxValue: 200.0
     property string unit: "km/h"
     property bool isStale: false
+    property string key: "speed"  // Signal whose threshold level colours the gauge
+    readonly property int level: signalLevel.level
+    property bool isWarning: level === 1
+    property bool isError: level === 2
     property color normalColor: "#4CAF50"
     property color warningColor: "#FFC107"
     property color errorColor: "#F44336"
+    readonly property color levelColor: level === 2 ? errorColor : level === 1 ? warningColor : normalColor
     
     // Signals
     signal clicked()
     signal valueChanged(real newValue)
     signal thresholdExceeded(real value, string threshold)
     
-    // Internal properties
-    property real warningThreshold: maxValue * 0.8
-    property real errorThreshold: maxValue * 0.9
+    // Internal properties; only used to draw the scale, the level comes
+    // from the model. The threshold engine's rule wins over the defaults.
+    readonly property var rule: dataModel.thresholdRule(key)
+    property real warningThreshold: rule.warning ?? maxValue * 0.8
+    property real errorThreshold: rule.error ?? maxValue * 0.9
+
+    SignalLevel {
+        id: signalLevel
+        key: gauge.key
+        onExceeded: (threshold, value) => gauge.thresholdExceeded(value, threshold)
+    }
 }
\ No newline at end of file
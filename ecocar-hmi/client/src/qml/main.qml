@@ -55,21 +55,66 @@ ApplicationWindow {
             border.width: 1
             radius: 5
 
-            // Sample chart
+            // The last ten minutes of the main signals, fed from the signal
+            // history and downsampled to the chart's width
             ChartView {
                 id: chart
                 anchors.fill: parent
                 antialiasing: true
                 theme: ChartView.ChartThemeDark
                 
+                ValuesAxis {
+                    id: timeAxis
+                    min: -600
+                    max: 0
+                    titleText: "s"
+                }
+                
+                ValuesAxis {
+                    id: valueAxis
+                    min: 0
+                    max: 200
+                }
+                
+                // Min/max keeps every spike; LTTB draws fewer points and
+                // suits the slower signals
+                LineSeries {
+                    id: speedSeries
+                    name: "Speed (km/h)"
+                    axisX: timeAxis
+                    axisY: valueAxis
+                }
+                
+                LineSeries {
+                    id: voltageSeries
+                    name: "Battery (V)"
+                    axisX: timeAxis
+                    axisY: valueAxis
+                }
+                
                 LineSeries {
-                    name: "Sample Data"
-                    // Sample data points
-                    XYPoint { x: 0; y: 0 }
-                    XYPoint { x: 1; y: 2 }
-                    XYPoint { x: 2; y: 1 }
-                    XYPoint { x: 3; y: 3 }
-                    XYPoint { x: 4; y: 2 }
+                    id: motorTempSeries
+                    name: "Motor (°C)"
+                    axisX: timeAxis
+                    axisY: valueAxis
+                }
+                
+                LineSeries {
+                    id: batteryTempSeries
+                    name: "Battery (°C)"
+                    axisX: timeAxis
+                    axisY: valueAxis
+                }
+                
+                Connections {
+                    target: dataModel
+                    function onHistoryUpdated() {
+                        const seconds = -timeAxis.min
+                        dataModel.updateSeries(speedSeries, "speed", seconds, "minmax")
+                        dataModel.updateSeries(voltageSeries, "battery_voltage", seconds, "lttb")
+                        dataModel.updateSeries(motorTempSeries, "motor_temp", seconds, "lttb")
+                        dataModel.updateSeries(batteryTempSeries, "battery_temp", seconds, "lttb")
+                    }
                 }
             }
         }
@@ -84,6 +129,13 @@ ApplicationWindow {
                 Layout.fillWidth: true
                 padding: 10
             }
+            // Re-evaluated only on threshold transitions
+            Label {
+                visible: dataModel.alertLevel > 0
+                text: dataModel.alertKey + (dataModel.alertLevel === 2 ? " error" : " warning")
+                color: dataModel.alertLevel === 2 ? "#F44336" : "#FFC107"
+                padding: 10
+            }
             Label {
                 text: Qt.formatDateTime(new Date(), "hh:mm:ss")
                 padding: 10
@@ -0,0 +1,300 @@
+#include "shmsnapshot.h"
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::uint64_t doubleBits(double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(std::uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Never equal to a published sequence, which is always even
+const std::uint64_t NO_SEQUENCE = ~std::uint64_t(0);
+
+} // namespace
+
+std::size_t shm::segmentSize(int slotCount)
+{
+    return sizeof(Header) + std::size_t(slotCount) * sizeof(Slot);
+}
+
+ShmSnapshotReader::ShmSnapshotReader(const SignalSchema &schema)
+    : schema(schema)
+    , mapping(nullptr)
+    , mappingSize(0)
+    , header(nullptr)
+    , slots(nullptr)
+    , lastSequence(NO_SEQUENCE)
+    , lastStatusSequence(NO_SEQUENCE)
+    , m_retries(0)
+{
+}
+
+ShmSnapshotReader::~ShmSnapshotReader()
+{
+    detach();
+}
+
+bool ShmSnapshotReader::attach(const char *name)
+{
+    detach();
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || std::size_t(info.st_size) < sizeof(shm::Header)) {
+        close(fd);
+        return false;
+    }
+    void *address = mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    mapping = address;
+    mappingSize = std::size_t(info.st_size);
+    header = static_cast<const shm::Header *>(mapping);
+
+    // The writer stores the magic last, so a half-initialised segment is
+    // rejected here and picked up on a later attempt
+    if (header->magic.load(std::memory_order_acquire) != shm::MAGIC
+        || header->version != shm::VERSION
+        || shm::segmentSize(int(header->slotCount)) > mappingSize) {
+        detach();
+        return false;
+    }
+
+    slots = reinterpret_cast<const shm::Slot *>(header + 1);
+    slotMap.assign(header->slotCount, -1);
+    for (std::uint32_t i = 0; i < header->slotCount; ++i) {
+        const char *key = slots[i].key;
+        slotMap[i] = schema.indexOf(key, strnlen(key, shm::KEY_SIZE));
+    }
+    lastSequence = NO_SEQUENCE;
+    lastStatusSequence = NO_SEQUENCE;
+    return true;
+}
+
+void ShmSnapshotReader::detach()
+{
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    slots = nullptr;
+    slotMap.clear();
+}
+
+bool ShmSnapshotReader::isAttached() const
+{
+    return header != nullptr;
+}
+
+std::uint64_t ShmSnapshotReader::retries() const
+{
+    return m_retries;
+}
+
+ShmSnapshotReader::Result ShmSnapshotReader::read(SignalTable &table, SystemStatus &status,
+                                                  bool &statusUpdated)
+{
+    statusUpdated = false;
+    if (!header) {
+        return Detached;
+    }
+    // Cleared by the writer on shutdown
+    if (header->magic.load(std::memory_order_relaxed) != shm::MAGIC) {
+        return Detached;
+    }
+
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        std::uint64_t begin = header->sequence.load(std::memory_order_acquire);
+        if (begin & 1) {
+            ++m_retries;
+            continue;
+        }
+        if (begin == lastSequence) {
+            return Unchanged;
+        }
+
+        for (std::size_t i = 0; i < slotMap.size(); ++i) {
+            if (slotMap[i] < 0) {
+                continue;
+            }
+            const shm::Slot &slot = slots[i];
+            SignalSample &sample = table.stage(slotMap[i]);
+            std::uint32_t flags = slot.flags.load(std::memory_order_relaxed);
+            sample.value = bitsDouble(slot.valueBits.load(std::memory_order_relaxed));
+            sample.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+            sample.valid = flags & shm::Valid;
+            sample.stale = flags & shm::Stale;
+        }
+
+        std::uint64_t statusSequence = header->statusSequence.load(std::memory_order_relaxed);
+        SystemStatus published;
+        if (statusSequence != lastStatusSequence) {
+            published.connected = header->connected.load(std::memory_order_relaxed) != 0;
+            published.errorCount = header->errorCount.load(std::memory_order_relaxed);
+            published.uptime = header->uptime.load(std::memory_order_relaxed);
+            published.messageRate = bitsDouble(header->messageRateBits.load(std::memory_order_relaxed));
+        }
+
+        // Orders the copies above before the re-check of the sequence
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) != begin) {
+            table.discard();
+            ++m_retries;
+            continue;
+        }
+
+        lastSequence = begin;
+        if (statusSequence != lastStatusSequence) {
+            lastStatusSequence = statusSequence;
+            status = published;
+            statusUpdated = true;
+        }
+        return Updated;
+    }
+    return Busy;
+}
+
+ShmSnapshotWriter::ShmSnapshotWriter(const SignalSchema &schema)
+    : schema(schema)
+    , mapping(nullptr)
+    , mappingSize(0)
+    , header(nullptr)
+    , slots(nullptr)
+    , sequence(0)
+{
+}
+
+ShmSnapshotWriter::~ShmSnapshotWriter()
+{
+    destroy();
+}
+
+bool ShmSnapshotWriter::create(const char *segmentName)
+{
+    destroy();
+
+    // A fresh object rather than reusing a leftover one: readers still
+    // mapping the old segment see its magic cleared and re-attach
+    shm_unlink(segmentName);
+    int fd = shm_open(segmentName, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    std::size_t size = shm::segmentSize(schema.size());
+    if (ftruncate(fd, off_t(size)) != 0) {
+        close(fd);
+        shm_unlink(segmentName);
+        return false;
+    }
+    void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        shm_unlink(segmentName);
+        return false;
+    }
+    mapping = address;
+    mappingSize = size;
+    name.assign(segmentName, segmentName + std::strlen(segmentName) + 1);
+
+    header = new (mapping) shm::Header;
+    header->version = shm::VERSION;
+    header->slotCount = std::uint32_t(schema.size());
+    header->reserved = 0;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->statusSequence.store(0, std::memory_order_relaxed);
+    header->connected.store(0, std::memory_order_relaxed);
+    header->padding = 0;
+    header->errorCount.store(0, std::memory_order_relaxed);
+    header->uptime.store(0, std::memory_order_relaxed);
+    header->messageRateBits.store(doubleBits(0.0), std::memory_order_relaxed);
+
+    slots = new (header + 1) shm::Slot[schema.size()];
+    for (int i = 0; i < schema.size(); ++i) {
+        shm::Slot &slot = slots[i];
+        std::memset(slot.key, 0, sizeof(slot.key));
+        std::strncpy(slot.key, schema.at(i).key, shm::KEY_SIZE - 1);
+        slot.valueBits.store(doubleBits(0.0), std::memory_order_relaxed);
+        slot.timestamp.store(0, std::memory_order_relaxed);
+        slot.flags.store(0, std::memory_order_relaxed);
+        slot.reserved = 0;
+    }
+    sequence = 0;
+
+    header->magic.store(shm::MAGIC, std::memory_order_release);
+    return true;
+}
+
+void ShmSnapshotWriter::destroy()
+{
+    if (!mapping) {
+        return;
+    }
+    header->magic.store(0, std::memory_order_release);
+    munmap(mapping, mappingSize);
+    shm_unlink(name.data());
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    slots = nullptr;
+    name.clear();
+}
+
+void ShmSnapshotWriter::beginUpdate()
+{
+    header->sequence.store(++sequence, std::memory_order_relaxed);
+    // Keeps the data stores below from becoming visible before the odd
+    // sequence does
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ShmSnapshotWriter::setSample(int index, const SignalSample &sample)
+{
+    shm::Slot &slot = slots[index];
+    std::uint32_t flags = 0;
+    if (sample.valid) {
+        flags |= shm::Valid;
+    }
+    if (sample.stale) {
+        flags |= shm::Stale;
+    }
+    slot.valueBits.store(doubleBits(sample.value), std::memory_order_relaxed);
+    slot.timestamp.store(sample.timestamp, std::memory_order_relaxed);
+    slot.flags.store(flags, std::memory_order_relaxed);
+}
+
+void ShmSnapshotWriter::setStatus(const SystemStatus &status)
+{
+    header->connected.store(status.connected ? 1 : 0, std::memory_order_relaxed);
+    header->errorCount.store(status.errorCount, std::memory_order_relaxed);
+    header->uptime.store(status.uptime, std::memory_order_relaxed);
+    header->messageRateBits.store(doubleBits(status.messageRate), std::memory_order_relaxed);
+    header->statusSequence.store(header->statusSequence.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+}
+
+void ShmSnapshotWriter::endUpdate()
+{
+    header->sequence.store(++sequence, std::memory_order_release);
+}
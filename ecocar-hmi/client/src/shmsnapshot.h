@@ -0,0 +1,134 @@
+#ifndef SHMSNAPSHOT_H
+#define SHMSNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "payloaddecoder.h"
+#include "signaltable.h"
+
+// Fixed layout of the POSIX shared-memory segment a gateway process on the
+// same board publishes the latest signal values in. The writer owns the
+// segment and updates it under a single seqlock covering the whole table,
+// so a reader either sees one complete update or retries; it never blocks
+// the writer and never makes a syscall.
+//
+// Every field the writer changes after creation is a lock-free atomic so
+// both sides stay data-race free; the seqlock only decides whether a copy
+// is consistent.
+namespace shm {
+
+const std::uint32_t MAGIC = 0x45434853;  // "ECHS"
+const std::uint32_t VERSION = 1;
+const int KEY_SIZE = 32;
+
+enum SlotFlags : std::uint32_t {
+    Valid = 1u << 0,
+    Stale = 1u << 1
+};
+
+struct Slot {
+    char key[KEY_SIZE];  // Written once, before the header is published
+    std::atomic<std::uint64_t> valueBits;  // IEEE 754 double
+    std::atomic<std::int64_t> timestamp;
+    std::atomic<std::uint32_t> flags;
+    std::uint32_t reserved;
+};
+
+struct Header {
+    std::atomic<std::uint32_t> magic;  // Stored last by the writer
+    std::uint32_t version;
+    std::uint32_t slotCount;
+    std::uint32_t reserved;
+    std::atomic<std::uint64_t> sequence;  // Odd while an update is in progress
+    std::atomic<std::uint64_t> statusSequence;  // Bumped by every status update
+    std::atomic<std::uint32_t> connected;
+    std::uint32_t padding;
+    std::atomic<std::int64_t> errorCount;
+    std::atomic<std::int64_t> uptime;
+    std::atomic<std::uint64_t> messageRateBits;  // IEEE 754 double
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "shared-memory atomics must not fall back to a process-local lock");
+
+std::size_t segmentSize(int slotCount);
+
+} // namespace shm
+
+// Maps the segment read-only and copies consistent snapshots out of it.
+// Segment slots are matched to schema slots by key once, at attach().
+class ShmSnapshotReader {
+public:
+    enum Result {
+        Updated,    // New data staged into the table
+        Unchanged,  // Nothing written since the last read
+        Busy,       // Writer kept the seqlock across every attempt
+        Detached
+    };
+
+    explicit ShmSnapshotReader(const SignalSchema &schema);
+    ~ShmSnapshotReader();
+
+    ShmSnapshotReader(const ShmSnapshotReader &) = delete;
+    ShmSnapshotReader &operator=(const ShmSnapshotReader &) = delete;
+
+    // `name` is a shm_open() name such as "/ecocar-hmi"
+    bool attach(const char *name);
+    void detach();
+    bool isAttached() const;
+
+    // Stages every mapped slot into `table`; the caller commits or discards.
+    // `status` is only written, and `statusUpdated` only set, when the
+    // writer published a new status.
+    Result read(SignalTable &table, SystemStatus &status, bool &statusUpdated);
+
+    // Reads thrown away because the writer was mid-update
+    std::uint64_t retries() const;
+
+private:
+    static const int MAX_READ_ATTEMPTS = 64;
+
+    const SignalSchema &schema;
+    void *mapping;
+    std::size_t mappingSize;
+    const shm::Header *header;
+    const shm::Slot *slots;
+    std::vector<int> slotMap;  // Segment slot -> schema slot, -1 = unknown key
+    std::uint64_t lastSequence;
+    std::uint64_t lastStatusSequence;
+    std::uint64_t m_retries;
+};
+
+// Creates the segment and publishes updates into it. One writer per segment.
+class ShmSnapshotWriter {
+public:
+    explicit ShmSnapshotWriter(const SignalSchema &schema);
+    ~ShmSnapshotWriter();
+
+    ShmSnapshotWriter(const ShmSnapshotWriter &) = delete;
+    ShmSnapshotWriter &operator=(const ShmSnapshotWriter &) = delete;
+
+    // Replaces any segment left behind under `name`
+    bool create(const char *name);
+    void destroy();
+
+    // Everything between beginUpdate() and endUpdate() becomes visible to
+    // readers at once
+    void beginUpdate();
+    void setSample(int index, const SignalSample &sample);
+    void setStatus(const SystemStatus &status);
+    void endUpdate();
+
+private:
+    const SignalSchema &schema;
+    void *mapping;
+    std::size_t mappingSize;
+    shm::Header *header;
+    shm::Slot *slots;
+    std::vector<char> name;
+    std::uint64_t sequence;
+};
+
+#endif // SHMSNAPSHOT_H
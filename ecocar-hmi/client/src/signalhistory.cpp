@@ -0,0 +1,110 @@
+#include "signalhistory.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+    std::size_t result = 1;
+    while (result < value) {
+        result *= 2;
+    }
+    return result;
+}
+
+} // namespace
+
+HistoryRing::HistoryRing(std::size_t capacity)
+    : slots(new Slot[roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2))])
+    , mask(roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2)) - 1)
+    , claimed(0)
+    , published(0)
+    , lastTimestamp(INT64_MIN)
+{
+}
+
+std::size_t HistoryRing::capacity() const
+{
+    return mask + 1;
+}
+
+void HistoryRing::push(std::int64_t timestamp, double value)
+{
+    if (timestamp <= lastTimestamp) {
+        return;  // Re-sent sample, e.g. an unchanged value in a full poll
+    }
+    lastTimestamp = timestamp;
+
+    std::uint64_t position = published.load(std::memory_order_relaxed);
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    // Announce the overwrite before doing it, so a reader that copied the
+    // new contents is guaranteed to see the claim and drop the slot
+    claimed.store(position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot &slot = slots[position & mask];
+    slot.timestamp.store(timestamp, std::memory_order_relaxed);
+    slot.valueBits.store(bits, std::memory_order_relaxed);
+    published.store(position + 1, std::memory_order_release);
+}
+
+std::uint64_t HistoryRing::head() const
+{
+    return published.load(std::memory_order_acquire);
+}
+
+std::uint64_t HistoryRing::read(std::uint64_t from, std::vector<HistoryPoint> &out) const
+{
+    const std::uint64_t capacity = mask + 1;
+    std::uint64_t end = published.load(std::memory_order_acquire);
+    std::uint64_t begin = std::max(from, end > capacity ? end - capacity : 0);
+    if (begin >= end) {
+        return std::max(from, end);
+    }
+
+    std::size_t first = out.size();
+    for (std::uint64_t position = begin; position < end; ++position) {
+        const Slot &slot = slots[position & mask];
+        HistoryPoint point;
+        point.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        std::uint64_t bits = slot.valueBits.load(std::memory_order_relaxed);
+        std::memcpy(&point.value, &bits, sizeof(point.value));
+        out.push_back(point);
+    }
+
+    // Anything below the writer's claim minus one lap may have been
+    // overwritten while it was copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::uint64_t claim = claimed.load(std::memory_order_relaxed);
+    if (claim > capacity && claim - capacity > begin) {
+        std::uint64_t lost = std::min(claim - capacity - begin, end - begin);
+        out.erase(out.begin() + std::ptrdiff_t(first),
+                  out.begin() + std::ptrdiff_t(first + lost));
+    }
+    return end;
+}
+
+SignalHistory::SignalHistory(int signalCount, std::size_t depth)
+{
+    rings.reserve(signalCount);
+    for (int i = 0; i < signalCount; ++i) {
+        rings.emplace_back(new HistoryRing(depth));
+    }
+}
+
+int SignalHistory::size() const
+{
+    return int(rings.size());
+}
+
+HistoryRing &SignalHistory::at(int index)
+{
+    return *rings[index];
+}
+
+const HistoryRing &SignalHistory::at(int index) const
+{
+    return *rings[index];
+}
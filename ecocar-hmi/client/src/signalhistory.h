@@ -0,0 +1,61 @@
+#ifndef SIGNALHISTORY_H
+#define SIGNALHISTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct HistoryPoint {
+    std::int64_t timestamp;  // Source timestamp, ms since epoch
+    double value;
+};
+
+// Fixed-capacity ring of the most recent samples of one signal. One thread
+// pushes and any thread reads, without locks: a reader copies what it
+// wants and then drops whatever the writer may have overwritten meanwhile.
+// Storage is allocated once, in the constructor.
+class HistoryRing {
+public:
+    explicit HistoryRing(std::size_t capacity);
+
+    std::size_t capacity() const;
+
+    // Writer only. Samples not newer than the last one are ignored.
+    void push(std::int64_t timestamp, double value);
+
+    // Position after the newest sample; positions only ever grow
+    std::uint64_t head() const;
+
+    // Appends samples from position `from` onwards to `out`, skipping any
+    // already overwritten, and returns the position to continue from.
+    std::uint64_t read(std::uint64_t from, std::vector<HistoryPoint> &out) const;
+
+private:
+    struct Slot {
+        std::atomic<std::int64_t> timestamp{0};
+        std::atomic<std::uint64_t> valueBits{0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask;
+    std::atomic<std::uint64_t> claimed;    // Slot being written, +1
+    std::atomic<std::uint64_t> published;  // Samples readers may copy
+    std::int64_t lastTimestamp;            // Writer only
+};
+
+// One ring per schema slot
+class SignalHistory {
+public:
+    SignalHistory(int signalCount, std::size_t depth);
+
+    int size() const;
+    HistoryRing &at(int index);
+    const HistoryRing &at(int index) const;
+
+private:
+    std::vector<std::unique_ptr<HistoryRing>> rings;
+};
+
+#endif // SIGNALHISTORY_H
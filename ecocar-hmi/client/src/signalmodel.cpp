@@ -0,0 +1,121 @@
+#include "signalmodel.h"
+
+SignalModel::SignalModel(const SignalSchema &schema, QObject *parent)
+    : QAbstractListModel(parent)
+    , schema(schema)
+    , samples(schema.size())
+    , levels(schema.size(), 0)
+    , dirty(schema.size(), 0)
+    , firstDirty(schema.size())
+    , lastDirty(-1)
+{
+}
+
+int SignalModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(samples.size());
+}
+
+QVariant SignalModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= int(samples.size())) {
+        return QVariant();
+    }
+
+    const SignalSample &sample = samples[index.row()];
+    switch (role) {
+    case KeyRole:
+        return QString::fromLatin1(schema.at(index.row()).key);
+    case UnitRole:
+        return QString::fromUtf8(schema.at(index.row()).unit);
+    case Qt::DisplayRole:
+    case ValueRole:
+        return sample.value;
+    case TimestampRole:
+        return qint64(sample.timestamp);
+    case ValidRole:
+        return sample.valid;
+    case StaleRole:
+        return sample.stale;
+    case LevelRole:
+        return levels[index.row()];
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> SignalModel::roleNames() const
+{
+    return {
+        {KeyRole, "key"},
+        {UnitRole, "unit"},
+        {ValueRole, "value"},
+        {TimestampRole, "timestamp"},
+        {ValidRole, "valid"},
+        {StaleRole, "stale"},
+        {LevelRole, "level"},
+    };
+}
+
+int SignalModel::indexOf(const QString &key) const
+{
+    QByteArray latin1 = key.toLatin1();
+    return schema.indexOf(latin1.constData(), std::size_t(latin1.size()));
+}
+
+int SignalModel::level(int row) const
+{
+    return row >= 0 && row < int(levels.size()) ? levels[row] : 0;
+}
+
+const SignalSample &SignalModel::at(int row) const
+{
+    return samples[row];
+}
+
+bool SignalModel::update(int row, const SignalSample &sample, int level)
+{
+    SignalSample &current = samples[row];
+    bool changed = current.value != sample.value
+                   || current.valid != sample.valid
+                   || current.stale != sample.stale
+                   || levels[row] != level;
+    current = sample;
+    levels[row] = level;
+    if (!changed) {
+        return false;  // Timestamp only; no view shows it live
+    }
+
+    dirty[row] = 1;
+    firstDirty = qMin(firstDirty, row);
+    lastDirty = qMax(lastDirty, row);
+    return true;
+}
+
+int SignalModel::flush()
+{
+    static const QList<int> roles = {ValueRole, TimestampRole, ValidRole, StaleRole, LevelRole,
+                                     Qt::DisplayRole};
+
+    // One notification per run of adjacent dirty rows
+    int notifications = 0;
+    int row = firstDirty;
+    while (row <= lastDirty) {
+        if (!dirty[row]) {
+            ++row;
+            continue;
+        }
+        int end = row;
+        while (end + 1 <= lastDirty && dirty[end + 1]) {
+            ++end;
+        }
+        for (int i = row; i <= end; ++i) {
+            dirty[i] = 0;
+        }
+        emit dataChanged(index(row), index(end), roles);
+        ++notifications;
+        row = end + 1;
+    }
+    firstDirty = int(samples.size());
+    lastDirty = -1;
+    return notifications;
+}
@@ -0,0 +1,52 @@
+#ifndef SIGNALMODEL_H
+#define SIGNALMODEL_H
+
+#include <QtCore/QAbstractListModel>
+#include <vector>
+#include "signaltable.h"
+
+// Every signal of a schema as one row, in slot order, so QML can show any
+// number of them through delegates instead of a property per signal.
+// Updates are staged with update() and announced by flush(), which emits
+// one dataChanged() per run of adjacent changed rows and returns how many.
+class SignalModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        KeyRole = Qt::UserRole + 1,
+        UnitRole,
+        ValueRole,
+        TimestampRole,
+        ValidRole,
+        StaleRole,
+        LevelRole  // ThresholdEngine::Level: 0 normal, 1 warning, 2 error
+    };
+
+    explicit SignalModel(const SignalSchema &schema, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Row of a signal key, or -1
+    Q_INVOKABLE int indexOf(const QString &key) const;
+    // Level role of a row, 0 for a row that does not exist
+    Q_INVOKABLE int level(int row) const;
+
+    const SignalSample &at(int row) const;
+
+    // Returns false if nothing observable changed
+    bool update(int row, const SignalSample &sample, int level = 0);
+    int flush();
+
+private:
+    const SignalSchema &schema;
+    std::vector<SignalSample> samples;
+    std::vector<int> levels;
+    std::vector<char> dirty;
+    int firstDirty;
+    int lastDirty;
+};
+
+#endif // SIGNALMODEL_H
@@ -0,0 +1,162 @@
+#include "signaltable.h"
+#include <cstring>
+
+namespace {
+
+const SignalDef VEHICLE_SIGNALS[] = {
+    {"speed", "km/h"},
+    {"battery_voltage", "V"},
+    {"motor_temp", "°C"},
+    {"motor_rpm", "rpm"},
+    {"brake_pressure", "bar"},
+    {"accelerator_pos", "%"},
+    {"battery_current", "A"},
+    {"battery_temp", "°C"},
+    {"battery_soc", "%"},
+    // Computed in the client by DerivedSignals
+    {"power", "kW"},
+    {"energy_used", "Wh"},
+    {"trip_distance", "km"},
+    {"efficiency", "km/kWh"},
+    {"range", "km"},
+};
+
+} // namespace
+
+SignalSchema::SignalSchema(const SignalDef *defs, int count)
+    : defs(defs, defs + count)
+    , bucketMask(0)
+{
+    // Power-of-two table at most half full keeps probe chains short
+    std::size_t bucketCount = 4;
+    while (bucketCount < std::size_t(count) * 2) {
+        bucketCount *= 2;
+    }
+    bucketMask = bucketCount - 1;
+    buckets.assign(bucketCount, -1);
+
+    keyLengths.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        std::size_t length = std::strlen(defs[i].key);
+        keyLengths.push_back(length);
+        std::size_t bucket = hash(defs[i].key, length) & bucketMask;
+        while (buckets[bucket] >= 0) {
+            bucket = (bucket + 1) & bucketMask;
+        }
+        buckets[bucket] = i;
+    }
+}
+
+int SignalSchema::size() const
+{
+    return int(defs.size());
+}
+
+const SignalDef &SignalSchema::at(int index) const
+{
+    return defs[index];
+}
+
+int SignalSchema::indexOf(const char *key, std::size_t length) const
+{
+    std::size_t bucket = hash(key, length) & bucketMask;
+    for (;;) {
+        int index = buckets[bucket];
+        if (index < 0) {
+            return -1;
+        }
+        if (keyLengths[index] == length && std::memcmp(defs[index].key, key, length) == 0) {
+            return index;
+        }
+        bucket = (bucket + 1) & bucketMask;
+    }
+}
+
+int SignalSchema::indexOf(const char *key) const
+{
+    return indexOf(key, std::strlen(key));
+}
+
+const SignalSchema &SignalSchema::vehicle()
+{
+    static const SignalSchema schema(VEHICLE_SIGNALS,
+                                     int(sizeof(VEHICLE_SIGNALS) / sizeof(VEHICLE_SIGNALS[0])));
+    return schema;
+}
+
+std::uint32_t SignalSchema::hash(const char *key, std::size_t length)
+{
+    // FNV-1a
+    std::uint32_t h = 2166136261u;
+    for (std::size_t i = 0; i < length; ++i) {
+        h ^= std::uint8_t(key[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+SignalTable::SignalTable(int size)
+    : samples(size)
+    , staged(size)
+    , stagedFlags(size, 0)
+{
+    stagedIndices.reserve(size);
+    changedIndices.reserve(size);
+    updatedIndices.reserve(size);
+}
+
+int SignalTable::size() const
+{
+    return int(samples.size());
+}
+
+const SignalSample &SignalTable::at(int index) const
+{
+    return samples[index];
+}
+
+SignalSample &SignalTable::stage(int index)
+{
+    if (!stagedFlags[index]) {
+        stagedFlags[index] = 1;
+        stagedIndices.push_back(index);
+        staged[index] = samples[index];
+    }
+    return staged[index];
+}
+
+void SignalTable::commit()
+{
+    changedIndices.clear();
+    for (int index : stagedIndices) {
+        const SignalSample &next = staged[index];
+        SignalSample &current = samples[index];
+        if (current.value != next.value || current.valid != next.valid
+                || current.stale != next.stale) {
+            changedIndices.push_back(index);
+        }
+        current = next;
+        stagedFlags[index] = 0;
+    }
+    // Both keep their capacity, so this never allocates
+    updatedIndices.swap(stagedIndices);
+    stagedIndices.clear();
+}
+
+void SignalTable::discard()
+{
+    for (int index : stagedIndices) {
+        stagedFlags[index] = 0;
+    }
+    stagedIndices.clear();
+}
+
+const std::vector<int> &SignalTable::changed() const
+{
+    return changedIndices;
+}
+
+const std::vector<int> &SignalTable::updated() const
+{
+    return updatedIndices;
+}
@@ -0,0 +1,77 @@
+#ifndef SIGNALTABLE_H
+#define SIGNALTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One entry of the signal schema. `key` is the name used in the API
+// "messages" object.
+struct SignalDef {
+    const char *key;
+    const char *unit;
+};
+
+// Fixed set of signals known to the client. Each signal gets a slot index
+// once, at construction; lookups by name hash the raw key bytes so the
+// payload decoders never build a string.
+class SignalSchema {
+public:
+    SignalSchema(const SignalDef *defs, int count);
+
+    int size() const;
+    const SignalDef &at(int index) const;
+
+    // Slot index for a key taken straight from a payload, or -1
+    int indexOf(const char *key, std::size_t length) const;
+    int indexOf(const char *key) const;
+
+    // Signals served by the backend, in slot order
+    static const SignalSchema &vehicle();
+
+private:
+    std::vector<SignalDef> defs;
+    std::vector<std::size_t> keyLengths;
+    std::vector<int> buckets;  // Open addressing, -1 = empty
+    std::size_t bucketMask;
+
+    static std::uint32_t hash(const char *key, std::size_t length);
+};
+
+struct SignalSample {
+    double value = 0.0;
+    std::int64_t timestamp = 0;  // Source timestamp, ms since epoch
+    bool valid = false;
+    bool stale = false;
+};
+
+// Flat array of the latest sample per schema slot. Decoders write into a
+// staging copy; commit() applies every staged slot at once so a rejected
+// payload never leaves half an update behind. Nothing allocates after
+// construction.
+class SignalTable {
+public:
+    explicit SignalTable(int size);
+
+    int size() const;
+    const SignalSample &at(int index) const;
+
+    SignalSample &stage(int index);
+    void commit();
+    void discard();
+
+    // Slots whose value, validity or staleness changed at the last commit
+    const std::vector<int> &changed() const;
+    // Every slot written by the last commit, changed or not
+    const std::vector<int> &updated() const;
+
+private:
+    std::vector<SignalSample> samples;
+    std::vector<SignalSample> staged;
+    std::vector<char> stagedFlags;
+    std::vector<int> stagedIndices;
+    std::vector<int> changedIndices;
+    std::vector<int> updatedIndices;
+};
+
+#endif // SIGNALTABLE_H
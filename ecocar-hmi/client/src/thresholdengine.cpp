@@ -0,0 +1,137 @@
+#include "thresholdengine.h"
+#include <algorithm>
+
+namespace {
+
+struct DefaultRule {
+    const char *key;
+    ThresholdRule rule;
+};
+const DefaultRule DEFAULT_RULES[] = {
+    {"battery_temp", {45.0, 55.0, 1.0, false, 4, true}},
+    {"motor_temp", {80.0, 95.0, 2.0, false, 3, true}},
+    {"battery_voltage", {44.0, 42.0, 0.5, true, 2, true}},  // Undervoltage
+    {"speed", {160.0, 180.0, 2.0, false, 1, true}},
+};
+
+} // namespace
+
+ThresholdEngine::ThresholdEngine(const SignalSchema &schema)
+    : rules(defaultRules(schema))
+    , levels(schema.size(), Normal)
+    , sorted(true)
+    , top(-1)
+{
+    pending.reserve(schema.size());
+}
+
+std::vector<ThresholdRule> ThresholdEngine::defaultRules(const SignalSchema &schema)
+{
+    std::vector<ThresholdRule> rules(schema.size());
+    for (const DefaultRule &defaults : DEFAULT_RULES) {
+        int slot = schema.indexOf(defaults.key);
+        if (slot >= 0) {
+            rules[slot] = defaults.rule;
+        }
+    }
+    return rules;
+}
+
+void ThresholdEngine::setRule(int slot, const ThresholdRule &rule)
+{
+    rules[slot] = rule;
+}
+
+const ThresholdRule &ThresholdEngine::rule(int slot) const
+{
+    return rules[slot];
+}
+
+void ThresholdEngine::evaluate(int slot, const SignalSample &sample)
+{
+    const ThresholdRule &rule = rules[slot];
+    Level current = levels[slot];
+    Level next = Normal;
+    if (rule.enabled && sample.valid) {
+        next = levelFor(rule, current, sample.value);
+    }
+    if (next == current) {
+        return;
+    }
+
+    levels[slot] = next;
+    pending.push_back({slot, current, next, sample.value});
+    sorted = false;
+
+    // The top alert only needs a full scan when it is the one dropping
+    if (next != Normal && (top < 0 || outranks(slot, top))) {
+        top = slot;
+    } else if (slot == top) {
+        top = -1;
+        for (int i = 0; i < int(levels.size()); ++i) {
+            if (levels[i] != Normal && (top < 0 || outranks(i, top))) {
+                top = i;
+            }
+        }
+    }
+}
+
+ThresholdEngine::Level ThresholdEngine::level(int slot) const
+{
+    return levels[slot];
+}
+
+const std::vector<ThresholdEngine::Transition> &ThresholdEngine::transitions()
+{
+    if (!sorted) {
+        std::stable_sort(pending.begin(), pending.end(),
+                         [this](const Transition &a, const Transition &b) {
+            if (a.to != b.to) {
+                return a.to > b.to;
+            }
+            return rules[a.slot].priority > rules[b.slot].priority;
+        });
+        sorted = true;
+    }
+    return pending;
+}
+
+void ThresholdEngine::clearTransitions()
+{
+    pending.clear();
+    sorted = true;
+}
+
+int ThresholdEngine::topSlot() const
+{
+    return top;
+}
+
+ThresholdEngine::Level ThresholdEngine::levelFor(const ThresholdRule &rule, Level current,
+                                                 double value)
+{
+    // Work as if levels are entered going up
+    double sign = rule.below ? -1.0 : 1.0;
+    double x = value * sign;
+    double warning = rule.warning * sign;
+    double error = rule.error * sign;
+
+    auto levelAt = [warning, error](double v) {
+        return v >= error ? Error : v >= warning ? Warning : Normal;
+    };
+    // Up at once; down only as far as the value is past the hysteresis
+    Level raised = levelAt(x);
+    Level held = levelAt(x + rule.hysteresis);
+    if (held > current) {
+        held = current;
+    }
+    return raised > held ? raised : held;
+}
+
+bool ThresholdEngine::outranks(int slot, int other) const
+{
+    if (levels[slot] != levels[other]) {
+        return levels[slot] > levels[other];
+    }
+    return rules[slot].priority > rules[other].priority;
+}
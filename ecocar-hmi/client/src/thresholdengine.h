@@ -0,0 +1,68 @@
+#ifndef THRESHOLDENGINE_H
+#define THRESHOLDENGINE_H
+
+#include <vector>
+#include "signaltable.h"
+
+// Warning and error levels of a signal. A level is entered at its
+// threshold and only left once the value is `hysteresis` back past it.
+// Higher `priority` wins when several signals are in the same level.
+struct ThresholdRule {
+    double warning = 0.0;
+    double error = 0.0;
+    double hysteresis = 0.0;
+    bool below = false;  // Levels are entered going down, e.g. undervoltage
+    int priority = 0;
+    bool enabled = false;
+};
+
+// Evaluates the threshold rules of every signal as samples arrive and
+// records only the level transitions, so nothing has to compare values
+// against thresholds per component or per frame.
+class ThresholdEngine {
+public:
+    enum Level {
+        Normal = 0,
+        Warning = 1,
+        Error = 2
+    };
+
+    struct Transition {
+        int slot;
+        Level from;
+        Level to;
+        double value;
+    };
+
+    explicit ThresholdEngine(const SignalSchema &schema);
+
+    // The rules an engine starts with, one per slot of `schema`
+    static std::vector<ThresholdRule> defaultRules(const SignalSchema &schema);
+
+    void setRule(int slot, const ThresholdRule &rule);
+    const ThresholdRule &rule(int slot) const;
+
+    // Invalid samples count as Normal
+    void evaluate(int slot, const SignalSample &sample);
+    Level level(int slot) const;
+
+    // Transitions since the last clear, most severe and highest priority
+    // first
+    const std::vector<Transition> &transitions();
+    void clearTransitions();
+
+    // Signal whose alert matters most right now, or -1
+    int topSlot() const;
+
+private:
+    static Level levelFor(const ThresholdRule &rule, Level current, double value);
+    bool outranks(int slot, int other) const;
+
+    std::vector<ThresholdRule> rules;
+    std::vector<Level> levels;
+    std::vector<Transition> pending;
+    bool sorted;
+    int top;
+};
+
+#endif // THRESHOLDENGINE_H
@@ -0,0 +1,135 @@
+#include "timerwheel.h"
+
+TimerWheel::TimerWheel(int timerCount, std::int64_t tickNs, std::int64_t startNs)
+    : tickNs(tickNs > 0 ? tickNs : 1)
+    , currentTick(startNs / this->tickNs)
+    , count(0)
+    , heads(LEVELS * SLOTS, -1)
+    , next(timerCount, -1)
+    , prev(timerCount, -1)
+    , bucketOf(timerCount, -1)
+    , deadlineTick(timerCount, 0)
+{
+}
+
+void TimerWheel::schedule(int id, std::int64_t deadlineNs)
+{
+    if (bucketOf[id] >= 0) {
+        unlink(id);
+    } else {
+        ++count;
+    }
+    deadlineTick[id] = (deadlineNs + tickNs - 1) / tickNs;
+    insert(id);
+}
+
+void TimerWheel::cancel(int id)
+{
+    if (bucketOf[id] >= 0) {
+        unlink(id);
+        --count;
+    }
+}
+
+bool TimerWheel::isScheduled(int id) const
+{
+    return bucketOf[id] >= 0;
+}
+
+int TimerWheel::pending() const
+{
+    return count;
+}
+
+void TimerWheel::advance(std::int64_t nowNs, std::vector<int> &expired)
+{
+    std::int64_t target = nowNs / tickNs;
+    if (count == 0) {
+        if (target > currentTick) {
+            currentTick = target;
+        }
+        return;
+    }
+
+    while (currentTick < target && count > 0) {
+        ++currentTick;
+
+        // Entering a new slot of a coarser level moves its timers down
+        for (int level = 1; level < LEVELS; ++level) {
+            if ((currentTick & ((std::int64_t(1) << (SLOT_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            int bucket = level * SLOTS + int((currentTick >> (SLOT_BITS * level)) & (SLOTS - 1));
+            int id = heads[bucket];
+            heads[bucket] = -1;
+            while (id >= 0) {
+                int following = next[id];
+                bucketOf[id] = -1;
+                if (deadlineTick[id] <= currentTick) {
+                    --count;
+                    expired.push_back(id);
+                } else {
+                    insert(id);
+                }
+                id = following;
+            }
+        }
+
+        int bucket = int(currentTick & (SLOTS - 1));
+        int id = heads[bucket];
+        heads[bucket] = -1;
+        while (id >= 0) {
+            int following = next[id];
+            bucketOf[id] = -1;
+            --count;
+            expired.push_back(id);
+            id = following;
+        }
+    }
+    if (count == 0 && target > currentTick) {
+        currentTick = target;
+    }
+}
+
+void TimerWheel::insert(int id)
+{
+    // Overdue timers fire on the next tick
+    std::int64_t tick = deadlineTick[id] > currentTick ? deadlineTick[id] : currentTick + 1;
+    std::int64_t delta = tick - currentTick;
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (std::int64_t(1) << (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+    if (level == LEVELS - 1) {
+        // Beyond the top level: park it in the furthest slot, from where it
+        // cascades down and is placed again
+        std::int64_t span = std::int64_t(1) << (SLOT_BITS * LEVELS);
+        if (delta >= span) {
+            tick = currentTick + span - 1;
+        }
+    }
+
+    int bucket = level * SLOTS + int((tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+    prev[id] = -1;
+    next[id] = heads[bucket];
+    if (heads[bucket] >= 0) {
+        prev[heads[bucket]] = id;
+    }
+    heads[bucket] = id;
+    bucketOf[id] = bucket;
+}
+
+void TimerWheel::unlink(int id)
+{
+    int bucket = bucketOf[id];
+    if (prev[id] >= 0) {
+        next[prev[id]] = next[id];
+    } else {
+        heads[bucket] = next[id];
+    }
+    if (next[id] >= 0) {
+        prev[next[id]] = prev[id];
+    }
+    bucketOf[id] = -1;
+}
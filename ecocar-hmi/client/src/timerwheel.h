@@ -0,0 +1,45 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timer wheel for a fixed set of timers, identified by index.
+// Each level has SLOTS buckets, each SLOTS times coarser than the one
+// below; timers are kept in intrusive lists, so scheduling or cancelling
+// is O(1), and advance() touches only the timers that expire or cascade
+// down a level. Nothing allocates after construction.
+class TimerWheel {
+public:
+    // Time starts at `startNs`, on the same clock as every later call
+    TimerWheel(int timerCount, std::int64_t tickNs, std::int64_t startNs);
+
+    // Replaces any deadline `id` already had. Deadlines are rounded up to
+    // the next tick.
+    void schedule(int id, std::int64_t deadlineNs);
+    void cancel(int id);
+    bool isScheduled(int id) const;
+    int pending() const;
+
+    // Fires every timer due by `nowNs`, appending their ids to `expired`
+    void advance(std::int64_t nowNs, std::vector<int> &expired);
+
+private:
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 4;
+
+    void insert(int id);
+    void unlink(int id);
+
+    std::int64_t tickNs;
+    std::int64_t currentTick;
+    int count;
+    std::vector<int> heads;  // LEVELS * SLOTS lists, -1 = empty
+    std::vector<int> next;
+    std::vector<int> prev;
+    std::vector<int> bucketOf;  // -1 = not scheduled
+    std::vector<std::int64_t> deadlineTick;
+};
+
+#endif // TIMERWHEEL_H
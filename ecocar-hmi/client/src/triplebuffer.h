@@ -0,0 +1,61 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Three copies of a value handed between one writer and one reader
+// without locks. The writer fills its back buffer and publishes it with
+// one atomic exchange against the middle one; the reader exchanges its
+// front buffer for the middle one only if something newer was published.
+// Each side owns its buffer outright between exchanges, so a reader always
+// sees a complete value, and neither side ever waits for the other. A
+// value published twice before the reader looks is simply replaced.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : middle(1)
+        , back(0)
+        , front(2)
+    {
+    }
+
+    // Writer only. The buffer to fill next; it holds whatever was
+    // published two or more times ago, not the latest value.
+    T &writeBuffer()
+    {
+        return buffers[back];
+    }
+
+    void publish()
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader only. Moves to the newest published value; returns false,
+    // leaving the front buffer as it was, if nothing was published since.
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T &readBuffer() const
+    {
+        return buffers[front];
+    }
+
+private:
+    static const unsigned INDEX = 3;
+    static const unsigned FRESH = 4;  // Middle buffer not yet read
+
+    T buffers[3];
+    std::atomic<unsigned> middle;
+    unsigned back;   // Writer only
+    unsigned front;  // Reader only
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,269 @@
+#include "windowstats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const std::int64_t WINDOW_SPANS_MS[] = {1000, 10000, 60000};
+
+std::uint64_t roundUpToPowerOfTwo(std::uint64_t value)
+{
+    std::uint64_t result = 1;
+    while (result < value) {
+        result *= 2;
+    }
+    return result;
+}
+
+const double GAMMA = (1.0 + QuantileSketch::RELATIVE_ACCURACY)
+                     / (1.0 - QuantileSketch::RELATIVE_ACCURACY);
+const double LOG_GAMMA = std::log(GAMMA);
+const int BUCKET_OFFSET = int(std::ceil(std::log(QuantileSketch::MIN_MAGNITUDE) / LOG_GAMMA));
+
+} // namespace
+
+QuantileSketch::QuantileSketch()
+{
+    clear();
+}
+
+void QuantileSketch::add(double value)
+{
+    double magnitude = std::fabs(value);
+    if (magnitude < MIN_MAGNITUDE) {
+        ++zero;
+    } else if (value > 0) {
+        ++positive[bucketFor(magnitude)];
+    } else {
+        ++negative[bucketFor(magnitude)];
+    }
+    ++total;
+}
+
+void QuantileSketch::remove(double value)
+{
+    double magnitude = std::fabs(value);
+    if (magnitude < MIN_MAGNITUDE) {
+        --zero;
+    } else if (value > 0) {
+        --positive[bucketFor(magnitude)];
+    } else {
+        --negative[bucketFor(magnitude)];
+    }
+    --total;
+}
+
+void QuantileSketch::clear()
+{
+    std::memset(positive, 0, sizeof(positive));
+    std::memset(negative, 0, sizeof(negative));
+    zero = 0;
+    total = 0;
+}
+
+std::uint64_t QuantileSketch::count() const
+{
+    return total;
+}
+
+double QuantileSketch::quantile(double q) const
+{
+    if (total == 0) {
+        return 0.0;
+    }
+
+    // Rank of the wanted sample, walking up from the most negative
+    std::uint64_t rank = std::uint64_t(std::clamp(q, 0.0, 1.0) * double(total - 1));
+    std::uint64_t seen = 0;
+    for (int i = BUCKETS - 1; i >= 0; --i) {
+        seen += negative[i];
+        if (seen > rank) {
+            return -valueOf(i);
+        }
+    }
+    seen += zero;
+    if (seen > rank) {
+        return 0.0;
+    }
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += positive[i];
+        if (seen > rank) {
+            return valueOf(i);
+        }
+    }
+    return valueOf(BUCKETS - 1);
+}
+
+int QuantileSketch::bucketFor(double magnitude) const
+{
+    int bucket = int(std::ceil(std::log(magnitude) / LOG_GAMMA)) - BUCKET_OFFSET;
+    return std::clamp(bucket, 0, BUCKETS - 1);
+}
+
+double QuantileSketch::valueOf(int bucket) const
+{
+    // Midpoint, in relative terms, of (GAMMA^(i-1), GAMMA^i]
+    return 2.0 * std::pow(GAMMA, bucket + BUCKET_OFFSET) / (GAMMA + 1.0);
+}
+
+WindowStats::WindowStats(int rateHz)
+    : next(0)
+    , tripMin(0.0)
+    , tripMax(0.0)
+{
+    std::uint64_t largest = 0;
+    for (int i = 0; i < SLIDING_COUNT; ++i) {
+        Sliding &window = sliding[i];
+        window.span = WINDOW_SPANS_MS[i];
+        // Room for bursts at up to twice the nominal rate
+        std::uint64_t nominal = std::uint64_t(window.span) * std::uint64_t(std::max(rateHz, 1)) / 1000;
+        window.capacity = roundUpToPowerOfTwo(nominal * 2 + 1);
+        window.minimum.entries.resize(window.capacity);
+        window.maximum.entries.resize(window.capacity);
+        largest = std::max(largest, window.capacity);
+    }
+    samples.resize(largest);
+    mask = largest - 1;
+}
+
+void WindowStats::add(std::int64_t timestamp, double value)
+{
+    for (Sliding &window : sliding) {
+        evict(window, timestamp);
+    }
+
+    std::uint64_t position = next++;
+    samples[position & mask] = {timestamp, value};
+    std::uint32_t index = std::uint32_t(position & mask);
+
+    for (Sliding &window : sliding) {
+        // Entries that can never be the extreme again leave from the back
+        Deque &minimum = window.minimum;
+        std::uint64_t dequeMask = window.capacity - 1;
+        while (minimum.tail > minimum.head
+               && samples[minimum.entries[(minimum.tail - 1) & dequeMask]].value >= value) {
+            --minimum.tail;
+        }
+        minimum.entries[minimum.tail++ & dequeMask] = index;
+
+        Deque &maximum = window.maximum;
+        while (maximum.tail > maximum.head
+               && samples[maximum.entries[(maximum.tail - 1) & dequeMask]].value <= value) {
+            --maximum.tail;
+        }
+        maximum.entries[maximum.tail++ & dequeMask] = index;
+
+        push(window.running, value);
+        window.sketch.add(value);
+        if (++window.sinceRefresh >= window.capacity) {
+            refresh(window);
+        }
+    }
+
+    if (trip.count == 0) {
+        tripMin = value;
+        tripMax = value;
+    } else {
+        tripMin = std::min(tripMin, value);
+        tripMax = std::max(tripMax, value);
+    }
+    push(trip, value);
+    tripSketch.add(value);
+}
+
+StatsSummary WindowStats::summary(Window window) const
+{
+    if (window == Trip) {
+        StatsSummary summary = summarize(trip, tripSketch);
+        summary.min = tripMin;
+        summary.max = tripMax;
+        return summary;
+    }
+
+    const Sliding &current = sliding[window];
+    StatsSummary summary = summarize(current.running, current.sketch);
+    if (summary.count > 0) {
+        std::uint64_t dequeMask = current.capacity - 1;
+        summary.min = samples[current.minimum.entries[current.minimum.head & dequeMask]].value;
+        summary.max = samples[current.maximum.entries[current.maximum.head & dequeMask]].value;
+    }
+    return summary;
+}
+
+void WindowStats::resetTrip()
+{
+    trip = Running();
+    tripMin = 0.0;
+    tripMax = 0.0;
+    tripSketch.clear();
+}
+
+void WindowStats::push(Running &running, double value)
+{
+    ++running.count;
+    double delta = value - running.mean;
+    running.mean += delta / double(running.count);
+    running.m2 += delta * (value - running.mean);
+}
+
+void WindowStats::pop(Running &running, double value)
+{
+    if (running.count <= 1) {
+        running = Running();
+        return;
+    }
+    double delta = value - running.mean;
+    --running.count;
+    running.mean -= delta / double(running.count);
+    running.m2 -= delta * (value - running.mean);
+}
+
+StatsSummary WindowStats::summarize(const Running &running, const QuantileSketch &sketch)
+{
+    StatsSummary summary;
+    summary.count = running.count;
+    summary.mean = running.mean;
+    if (running.count > 1) {
+        summary.stddev = std::sqrt(std::max(0.0, running.m2 / double(running.count - 1)));
+    }
+    summary.p50 = sketch.quantile(0.5);
+    summary.p95 = sketch.quantile(0.95);
+    return summary;
+}
+
+void WindowStats::refresh(Sliding &window)
+{
+    // Removing samples from a running mean leaves rounding error behind;
+    // starting over once per window's worth of samples keeps it bounded
+    // at O(1) amortised
+    window.running = Running();
+    for (std::uint64_t position = window.start; position < next; ++position) {
+        push(window.running, samples[position & mask].value);
+    }
+    window.sinceRefresh = 0;
+}
+
+void WindowStats::evict(Sliding &window, std::int64_t now)
+{
+    // By age, or by count once a window is full: the slot about to be
+    // written must have left every window
+    std::uint64_t dequeMask = window.capacity - 1;
+    while (window.start < next
+           && (samples[window.start & mask].timestamp <= now - window.span
+               || next - window.start >= window.capacity)) {
+        std::uint32_t index = std::uint32_t(window.start & mask);
+        double value = samples[index].value;
+        if (window.minimum.tail > window.minimum.head
+                && window.minimum.entries[window.minimum.head & dequeMask] == index) {
+            ++window.minimum.head;
+        }
+        if (window.maximum.tail > window.maximum.head
+                && window.maximum.entries[window.maximum.head & dequeMask] == index) {
+            ++window.maximum.head;
+        }
+        pop(window.running, value);
+        window.sketch.remove(value);
+        ++window.start;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef WINDOWSTATS_H
+#define WINDOWSTATS_H
+
+#include <cstdint>
+#include <vector>
+
+// Fixed-memory quantile sketch: counts in logarithmic buckets, so any
+// quantile is within RELATIVE_ACCURACY of the true value (for magnitudes
+// from MIN_MAGNITUDE up; smaller ones count as zero). Values can be
+// removed again, which sliding windows need.
+class QuantileSketch {
+public:
+    static constexpr double RELATIVE_ACCURACY = 0.02;
+    static constexpr double MIN_MAGNITUDE = 1e-3;
+
+    QuantileSketch();
+
+    void add(double value);
+    void remove(double value);
+    void clear();
+
+    std::uint64_t count() const;
+    // `q` in [0, 1]; 0 when empty
+    double quantile(double q) const;
+
+private:
+    static const int BUCKETS = 512;  // Covers 1e-3 to about 1e6
+
+    int bucketFor(double magnitude) const;
+    double valueOf(int bucket) const;
+
+    std::uint32_t positive[BUCKETS];
+    std::uint32_t negative[BUCKETS];
+    std::uint32_t zero;
+    std::uint64_t total;
+};
+
+struct StatsSummary {
+    std::uint64_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+};
+
+// Rolling statistics of one signal over the last second, ten seconds and
+// minute, and over the whole trip. Each sample costs O(1): min and max
+// come from monotonic deques, mean and variance from Welford's update (and
+// its inverse as samples leave a window), percentiles from a sketch. The
+// sliding windows share one sample FIFO sized for the longest of them at
+// twice `rateHz` (about 400 KB per signal at 100 Hz); faster signals lose
+// their oldest samples early rather than grow it. Nothing allocates after
+// construction.
+class WindowStats {
+public:
+    enum Window {
+        Second,
+        TenSeconds,
+        Minute,
+        Trip,
+        WINDOW_COUNT
+    };
+
+    explicit WindowStats(int rateHz);
+
+    // Samples must arrive in timestamp order
+    void add(std::int64_t timestamp, double value);
+    StatsSummary summary(Window window) const;
+    void resetTrip();
+
+private:
+    static const int SLIDING_COUNT = Trip;
+
+    struct Sample {
+        std::int64_t timestamp;
+        double value;
+    };
+
+    // Ring of FIFO indices (position & mask), oldest at head
+    struct Deque {
+        std::vector<std::uint32_t> entries;
+        std::uint64_t head = 0;
+        std::uint64_t tail = 0;
+    };
+
+    struct Running {
+        std::uint64_t count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+    };
+
+    struct Sliding {
+        std::int64_t span;
+        std::uint64_t capacity;
+        std::uint64_t start = 0;  // FIFO position of the oldest sample in the window
+        std::uint64_t sinceRefresh = 0;
+        Deque minimum;
+        Deque maximum;
+        Running running;
+        QuantileSketch sketch;
+    };
+
+    static void push(Running &running, double value);
+    static void pop(Running &running, double value);
+    static StatsSummary summarize(const Running &running, const QuantileSketch &sketch);
+    void evict(Sliding &window, std::int64_t now);
+    void refresh(Sliding &window);
+
+    std::vector<Sample> samples;
+    std::uint64_t mask;
+    std::uint64_t next;  // FIFO position of the next sample
+    Sliding sliding[SLIDING_COUNT];
+
+    Running trip;
+    double tripMin;
+    double tripMax;
+    QuantileSketch tripSketch;
+};
+
+#endif // WINDOWSTATS_H
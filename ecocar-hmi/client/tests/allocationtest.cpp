@@ -0,0 +1,196 @@
+// Regression check that decoding a payload into the signal table does not
+// allocate once warmed up. Built with ECOCAR_COUNT_ALLOCATIONS, so
+// allocationcounter.cpp replaces global operator new:
+//
+//     ecocar-allocation-test [--rounds 1000]
+//
+// A JSON and a CBOR snapshot carrying every vehicle signal, each in two
+// versions with different values, are decoded and committed in turn.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "allocationcounter.h"
+#include "payloaddecoder.h"
+
+namespace {
+
+const int WARMUP_ROUNDS = 10;
+
+// Just enough of RFC 8949 for a snapshot payload
+class CborWriter {
+public:
+    void map(std::size_t size)
+    {
+        head(5, size);
+    }
+
+    void text(const char *value)
+    {
+        std::size_t length = std::strlen(value);
+        head(3, length);
+        out.append(value, length);
+    }
+
+    void number(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        out.push_back(char(0xfb));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out.push_back(char(bits >> shift & 0xff));
+        }
+    }
+
+    void boolean(bool value)
+    {
+        out.push_back(char(value ? 0xf5 : 0xf4));
+    }
+
+    std::string out;
+
+private:
+    void head(int major, std::uint64_t argument)
+    {
+        if (argument < 24) {
+            out.push_back(char(major << 5 | int(argument)));
+        } else {
+            out.push_back(char(major << 5 | 27));
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                out.push_back(char(argument >> shift & 0xff));
+            }
+        }
+    }
+};
+
+std::string jsonSnapshot(const SignalSchema &schema, std::int64_t timestamp, double base)
+{
+    std::string json = "{\"latest\":{\"timestamp\":" + std::to_string(timestamp)
+                       + ",\"seq\":" + std::to_string(timestamp) + ",\"epoch\":\"1a2b\","
+                       + "\"since\":0,\"full\":true,\"messages\":{";
+    for (int i = 0; i < schema.size(); ++i) {
+        json += std::string(i ? "," : "") + "\"" + schema.at(i).key + "\":{\"value\":"
+                + std::to_string(base + i) + ",\"unit\":\"" + schema.at(i).unit
+                + "\",\"timestamp\":" + std::to_string(timestamp) + ",\"is_stale\":false}";
+    }
+    json += "}},\"status\":{\"connected\":true,\"uptime\":" + std::to_string(timestamp / 1000)
+            + ",\"message_rate\":100.0,\"error_count\":0}}";
+    return json;
+}
+
+std::string cborSnapshot(const SignalSchema &schema, std::int64_t timestamp, double base)
+{
+    CborWriter cbor;
+    cbor.map(2);
+    cbor.text("latest");
+    cbor.map(6);
+    cbor.text("timestamp");
+    cbor.number(double(timestamp));
+    cbor.text("seq");
+    cbor.number(double(timestamp));
+    cbor.text("epoch");
+    cbor.text("1a2b");
+    cbor.text("since");
+    cbor.number(0.0);
+    cbor.text("full");
+    cbor.boolean(true);
+    cbor.text("messages");
+    cbor.map(std::size_t(schema.size()));
+    for (int i = 0; i < schema.size(); ++i) {
+        cbor.text(schema.at(i).key);
+        cbor.map(4);
+        cbor.text("value");
+        cbor.number(base + i);
+        cbor.text("unit");
+        cbor.text(schema.at(i).unit);
+        cbor.text("timestamp");
+        cbor.number(double(timestamp));
+        cbor.text("is_stale");
+        cbor.boolean(false);
+    }
+    cbor.text("status");
+    cbor.map(4);
+    cbor.text("connected");
+    cbor.boolean(true);
+    cbor.text("uptime");
+    cbor.number(double(timestamp / 1000));
+    cbor.text("message_rate");
+    cbor.number(100.0);
+    cbor.text("error_count");
+    cbor.number(0.0);
+    return cbor.out;
+}
+
+// Allocations made while decoding and committing `rounds` times
+bool decodeRounds(const PayloadDecoder &decoder, const std::string payloads[2],
+                  PayloadDecoder::Format format, SignalTable &table, int rounds,
+                  std::uint64_t &allocated)
+{
+    std::uint64_t before = allocations::thisThread();
+    for (int round = 0; round < rounds; ++round) {
+        const std::string &payload = payloads[round % 2];
+        PayloadHeader header;
+        if (!decoder.decode(payload.data(), payload.size(), format, table, header)) {
+            return false;
+        }
+        table.commit();
+        if (table.changed().empty() || !header.hasStatus) {
+            return false;
+        }
+    }
+    allocated = allocations::thisThread() - before;
+    return true;
+}
+
+bool check(const char *name, const PayloadDecoder &decoder, const std::string payloads[2],
+           PayloadDecoder::Format format, SignalTable &table, int rounds)
+{
+    std::uint64_t allocated = 0;
+    if (!decodeRounds(decoder, payloads, format, table, WARMUP_ROUNDS, allocated)
+            || !decodeRounds(decoder, payloads, format, table, rounds, allocated)) {
+        std::fprintf(stderr, "FAIL: %s payload did not decode\n", name);
+        return false;
+    }
+    std::printf("%s: %llu allocations in %d warm decodes\n", name,
+                static_cast<unsigned long long>(allocated), rounds);
+    if (allocated != 0) {
+        std::fprintf(stderr, "FAIL: warm %s decoding allocates\n", name);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int rounds = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--rounds") == 0) {
+            rounds = std::max(2, std::atoi(argv[i + 1]));
+        }
+    }
+
+    // Without a working counter every check below would pass vacuously.
+    // operator new is called directly; a new-expression may be elided.
+    std::uint64_t before = allocations::thisThread();
+    ::operator delete(::operator new(64));
+    if (!allocations::counting() || allocations::thisThread() == before) {
+        std::fprintf(stderr, "FAIL: allocations are not being counted\n");
+        return 1;
+    }
+
+    const SignalSchema &schema = SignalSchema::vehicle();
+    const PayloadDecoder decoder(schema);
+    SignalTable table(schema.size());
+    const std::string json[2] = {jsonSnapshot(schema, 1700000000000, 10.5),
+                                 jsonSnapshot(schema, 1700000000100, 20.25)};
+    const std::string cbor[2] = {cborSnapshot(schema, 1700000000000, 10.5),
+                                 cborSnapshot(schema, 1700000000100, 20.25)};
+
+    bool ok = check("JSON", decoder, json, PayloadDecoder::Json, table, rounds);
+    ok = check("CBOR", decoder, cbor, PayloadDecoder::Cbor, table, rounds) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// Checks DisplayFilter deadbands at their boundaries and that threshold
+// levels from ThresholdEngine do not chatter around a threshold:
+//
+//     ecocar-displayfilter-test
+
+#include <cstdio>
+#include "displayfilter.h"
+#include "thresholdengine.h"
+
+namespace {
+
+const SignalDef SIGNALS[] = {
+    {"speed", "km/h"},
+    {"battery_voltage", "V"},
+    {"motor_temp", "C"},
+};
+
+int failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+SignalSample sample(double value, bool valid = true, bool stale = false)
+{
+    SignalSample result;
+    result.value = value;
+    result.valid = valid;
+    result.stale = stale;
+    return result;
+}
+
+void testAbsolute(const SignalSchema &schema)
+{
+    DisplayFilter filter(schema);
+    filter.setDeadband(0, {Deadband::Absolute, 0.5});
+    check(filter.accept(0, sample(10.0), 0), "absolute: first sample is shown");
+    check(!filter.accept(0, sample(10.4), 0), "absolute: just inside the band is held");
+    check(filter.accept(0, sample(10.5), 0), "absolute: the band edge is shown");
+    check(!filter.accept(0, sample(10.1), 0), "absolute: compared with the shown value");
+    check(filter.accept(0, sample(10.0), 0), "absolute: the band edge going down is shown");
+
+    // Small steps add up against the shown value instead of being lost
+    check(!filter.accept(0, sample(10.25), 0), "absolute: first small step is held");
+    check(filter.accept(0, sample(10.5), 0), "absolute: drift is shown once it adds up");
+    check(filter.suppressed() == 3, "absolute: held samples are counted");
+}
+
+void testRelative(const SignalSchema &schema)
+{
+    DisplayFilter filter(schema);
+    // 1/64 of the shown value, so the band edges are exact in binary
+    filter.setDeadband(1, {Deadband::Relative, 1.0 / 64.0});
+    check(filter.accept(1, sample(64.0), 0), "relative: first sample is shown");
+    check(!filter.accept(1, sample(64.99), 0), "relative: just inside the band is held");
+    check(filter.accept(1, sample(65.0), 0), "relative: the band edge is shown");
+    check(!filter.accept(1, sample(64.0), 0), "relative: the band follows the shown value");
+    check(filter.accept(1, sample(63.984375), 0), "relative: the band edge going down");
+}
+
+void testPrecision(const SignalSchema &schema)
+{
+    // Default: two decimals, as VehicleStatusView shows
+    DisplayFilter filter(schema);
+    check(filter.deadband(2).mode == Deadband::Precision, "precision: the default");
+    check(filter.accept(2, sample(55.004), 0), "precision: first sample is shown");
+    check(!filter.accept(2, sample(55.0049), 0), "precision: same two decimals are held");
+    check(filter.accept(2, sample(55.0051), 0), "precision: 55.01 is shown");
+    check(!filter.accept(2, sample(55.0149), 0), "precision: still 55.01 is held");
+
+    filter.setDeadband(2, {Deadband::Precision, 0.0});
+    check(!filter.accept(2, sample(55.49), 0), "precision 0: 55 is held");
+    check(filter.accept(2, sample(55.5), 0), "precision 0: 56 is shown");
+}
+
+void testAlwaysShown(const SignalSchema &schema)
+{
+    DisplayFilter filter(schema);
+    filter.setDeadband(0, {Deadband::Absolute, 100.0});
+    filter.accept(0, sample(50.0), 0);
+    check(filter.accept(0, sample(50.0, true, true), 0), "going stale is always shown");
+    check(filter.accept(0, sample(50.0, true, false), 0), "going fresh is always shown");
+    check(filter.accept(0, sample(50.0, false), 0), "going invalid is always shown");
+    check(!filter.accept(0, sample(90.0, false), 0), "invalid values are not compared");
+    check(filter.accept(0, sample(51.0), 0), "going valid is always shown");
+    check(filter.accept(0, sample(51.0), ThresholdEngine::Warning), "a level change is shown");
+    check(!filter.accept(0, sample(52.0), ThresholdEngine::Warning), "same level is held");
+
+    filter.setDeadband(0, {Deadband::None, 0.0});
+    check(filter.accept(0, sample(51.0000001), ThresholdEngine::Warning), "none: any change");
+    check(!filter.accept(0, sample(51.0000001), ThresholdEngine::Warning), "none: no change");
+}
+
+void testHysteresis(const SignalSchema &schema)
+{
+    // Speed warns at 160 and errors at 180, with 2 km/h of hysteresis
+    ThresholdEngine engine(schema);
+    engine.evaluate(0, sample(159.9));
+    check(engine.level(0) == ThresholdEngine::Normal, "hysteresis: below the warning");
+    engine.evaluate(0, sample(160.0));
+    check(engine.level(0) == ThresholdEngine::Warning, "hysteresis: warning at the threshold");
+
+    // Noise around the threshold, never 2 km/h back below it
+    const double noise[] = {159.0, 160.5, 158.1, 161.9, 158.01, 160.0, 159.99};
+    for (double value : noise) {
+        engine.evaluate(0, sample(value));
+    }
+    check(engine.level(0) == ThresholdEngine::Warning, "hysteresis: noise keeps the warning");
+    check(engine.transitions().size() == 1, "hysteresis: one transition through the noise");
+
+    engine.evaluate(0, sample(158.0));
+    check(engine.level(0) == ThresholdEngine::Warning, "hysteresis: held 2 km/h below");
+    engine.evaluate(0, sample(157.9));
+    check(engine.level(0) == ThresholdEngine::Normal, "hysteresis: left past 2 km/h below");
+    engine.evaluate(0, sample(159.9));
+    check(engine.level(0) == ThresholdEngine::Normal, "hysteresis: no re-entry below it");
+    engine.evaluate(0, sample(185.0));
+    check(engine.level(0) == ThresholdEngine::Error, "hysteresis: straight to error");
+    engine.evaluate(0, sample(178.5));
+    check(engine.level(0) == ThresholdEngine::Error, "hysteresis: error held within 2 km/h");
+    engine.evaluate(0, sample(177.9));
+    check(engine.level(0) == ThresholdEngine::Warning, "hysteresis: down one level at a time");
+
+    // Undervoltage counts downwards: warning at 44 V, 0.5 V of hysteresis
+    engine.evaluate(1, sample(44.0));
+    check(engine.level(1) == ThresholdEngine::Warning, "below: warning at the threshold");
+    engine.evaluate(1, sample(44.49));
+    check(engine.level(1) == ThresholdEngine::Warning, "below: held within the hysteresis");
+    engine.evaluate(1, sample(44.5));
+    check(engine.level(1) == ThresholdEngine::Warning, "below: held 0.5 V above it");
+    engine.evaluate(1, sample(44.51));
+    check(engine.level(1) == ThresholdEngine::Normal, "below: left past 0.5 V above it");
+
+    engine.evaluate(0, sample(170.0, false));
+    check(engine.level(0) == ThresholdEngine::Normal, "an invalid sample is normal");
+}
+
+} // namespace
+
+int main()
+{
+    SignalSchema schema(SIGNALS, int(sizeof(SIGNALS) / sizeof(SIGNALS[0])));
+    testAbsolute(schema);
+    testRelative(schema);
+    testPrecision(schema);
+    testAlwaysShown(schema);
+    testHysteresis(schema);
+    if (failures > 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all display filter checks passed\n");
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Checks Interpolator values between, before and after samples, the
+// extrapolation horizon and the latency it reports, and the largest error
+// against a known curve replayed at 10 Hz and rendered at 60 fps:
+//
+//     ecocar-interpolator-test
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "interpolator.h"
+
+namespace {
+
+// Samples reach us this long after their source timestamp
+const std::int64_t DELIVERY_MS = 5;
+
+// Ground truth: 50 +- 20 with a 2 s period, sampled every 100 ms
+const double PI = 3.14159265358979323846;
+const double AMPLITUDE = 20.0;
+const double PERIOD_MS = 2000.0;
+const std::int64_t SAMPLE_MS = 100;
+const std::int64_t FRAME_MS = 16;
+
+int failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+void checkValue(const Interpolator &interpolator, std::int64_t nowMs, double expected,
+                const char *what)
+{
+    double value = 0.0;
+    bool ok = interpolator.valueAt(0, nowMs, value);
+    if (!ok || std::fabs(value - expected) > 1e-9) {
+        std::fprintf(stderr, "FAIL: %s: got %g at %lld ms, expected %g\n", what, value,
+                     static_cast<long long>(nowMs), expected);
+        ++failures;
+    }
+}
+
+// 10, 20 and 30 at 100 ms intervals
+void feed(Interpolator &interpolator)
+{
+    for (int i = 0; i < 3; ++i) {
+        std::int64_t timestamp = 1000 + 100 * i;
+        interpolator.add(0, timestamp, 10.0 * (i + 1), timestamp + DELIVERY_MS);
+    }
+}
+
+void testInterpolate()
+{
+    Interpolator interpolator(1);
+    interpolator.setMode(0, Interpolator::Interpolate);
+    double value;
+    check(!interpolator.valueAt(0, 1000, value), "interpolate: no value before a sample");
+    feed(interpolator);
+
+    // One interval behind: rendering at now - delivery - 100 ms
+    check(interpolator.latency(0) == 100, "interpolate: latency is the sample interval");
+    checkValue(interpolator, 1255, 25.0, "interpolate: halfway between samples");
+    checkValue(interpolator, 1230, 22.5, "interpolate: along the segment");
+    checkValue(interpolator, 1205, 20.0, "interpolate: on a sample");
+    checkValue(interpolator, 1000, 10.0, "interpolate: before the oldest sample");
+    checkValue(interpolator, 1305, 30.0, "interpolate: at the newest sample");
+    checkValue(interpolator, 2000, 30.0, "interpolate: held after the newest sample");
+    check(interpolator.isMoving(0, 1255), "interpolate: moving between samples");
+    check(!interpolator.isMoving(0, 1305), "interpolate: settled at the newest sample");
+
+    // Older or repeated timestamps are dropped
+    interpolator.add(0, 1200, 99.0, 1400);
+    interpolator.add(0, 1150, 99.0, 1400);
+    checkValue(interpolator, 2000, 30.0, "interpolate: old samples are dropped");
+
+    // A late arrival adds its lateness to the delay, up to MAX_DELAY_MS
+    interpolator.add(0, 1300, 40.0, 1300 + DELIVERY_MS + 20);
+    check(interpolator.latency(0) == 120, "interpolate: jitter adds to the latency");
+    interpolator.add(0, 3300, 40.0, 3300 + DELIVERY_MS);
+    interpolator.add(0, 5300, 40.0, 5300 + DELIVERY_MS);
+    check(interpolator.latency(0) == Interpolator::MAX_DELAY_MS,
+          "interpolate: latency is capped");
+
+    // A step back further than MAX_DELAY_MS starts the signal over
+    interpolator.add(0, 100, 7.0, 6000);
+    checkValue(interpolator, 6000, 7.0, "interpolate: follows a clock step back");
+
+    interpolator.clear(0);
+    check(!interpolator.valueAt(0, 6000, value), "interpolate: nothing after clear");
+}
+
+void testExtrapolate()
+{
+    Interpolator interpolator(1);
+    interpolator.setMode(0, Interpolator::Extrapolate);
+    feed(interpolator);
+
+    // Projected at 0.1 per ms from the last two samples, without delay
+    check(interpolator.latency(0) == 0, "extrapolate: no latency");
+    checkValue(interpolator, 1205, 30.0, "extrapolate: on the newest sample");
+    checkValue(interpolator, 1255, 35.0, "extrapolate: projected past it");
+    checkValue(interpolator, 1355, 45.0, "extrapolate: up to the horizon");
+    checkValue(interpolator, 1400, 45.0, "extrapolate: held after the horizon");
+    checkValue(interpolator, 5000, 45.0, "extrapolate: held long after the horizon");
+    check(interpolator.isMoving(0, 1300), "extrapolate: moving within the horizon");
+    check(!interpolator.isMoving(0, 1355), "extrapolate: settled at the horizon");
+
+    interpolator.setHorizon(50);
+    checkValue(interpolator, 1400, 35.0, "extrapolate: a shorter horizon");
+    interpolator.setHorizon(-10);
+    checkValue(interpolator, 1400, 30.0, "extrapolate: a negative horizon holds");
+
+    // A level signal does not move however far it is projected
+    interpolator.add(0, 1300, 30.0, 1300 + DELIVERY_MS);
+    interpolator.setHorizon(Interpolator::DEFAULT_HORIZON_MS);
+    checkValue(interpolator, 1400, 30.0, "extrapolate: flat after a level pair");
+    check(!interpolator.isMoving(0, 1310), "extrapolate: a level pair is not moving");
+
+    // One sample cannot be projected
+    Interpolator single(1);
+    single.setMode(0, Interpolator::Extrapolate);
+    single.add(0, 1000, 10.0, 1000 + DELIVERY_MS);
+    checkValue(single, 1100, 10.0, "extrapolate: one sample is held");
+}
+
+double truth(double timeMs)
+{
+    return 50.0 + AMPLITUDE * std::sin(2.0 * PI * timeMs / PERIOD_MS);
+}
+
+// Largest |shown - truth| over 10 s of frames, against the curve at the
+// source time the shown value stands for: now less the delivery delay and
+// the latency the interpolator reports
+double maxError(Interpolator::Mode mode)
+{
+    Interpolator interpolator(1);
+    interpolator.setMode(0, mode);
+    std::int64_t nextSample = 0;
+    double worst = 0.0;
+    for (std::int64_t now = 0; now <= 10000; now += FRAME_MS) {
+        while (nextSample + DELIVERY_MS <= now) {
+            interpolator.add(0, nextSample, truth(double(nextSample)), nextSample + DELIVERY_MS);
+            nextSample += SAMPLE_MS;
+        }
+        double value;
+        if (now < 1000 || !interpolator.valueAt(0, now, value)) {
+            continue;  // Let the interval estimate settle first
+        }
+        double source = double(now - DELIVERY_MS - interpolator.latency(0));
+        worst = std::max(worst, std::fabs(value - truth(source)));
+    }
+    return worst;
+}
+
+void testGroundTruth()
+{
+    // Straight lines between samples are off by at most f''max * h^2 / 8
+    const double omega = 2.0 * PI / PERIOD_MS;
+    const double curvature = AMPLITUDE * omega * omega;
+    const double h = double(SAMPLE_MS);
+    double interpolated = maxError(Interpolator::Interpolate);
+    std::printf("interpolate: max error %.4f, samples every %lld ms (bound %.4f)\n", interpolated,
+                static_cast<long long>(SAMPLE_MS), curvature * h * h / 8.0);
+    check(interpolated <= curvature * h * h / 8.0, "ground truth: interpolation error bound");
+
+    // Projecting a chord up to h past its end: off by at most f''max * h * 2h / 2
+    double extrapolated = maxError(Interpolator::Extrapolate);
+    std::printf("extrapolate: max error %.4f at no latency (bound %.4f)\n", extrapolated,
+                curvature * h * h);
+    check(extrapolated <= curvature * h * h, "ground truth: extrapolation error bound");
+    check(interpolated < extrapolated, "ground truth: interpolation is the more accurate");
+}
+
+} // namespace
+
+int main()
+{
+    testInterpolate();
+    testExtrapolate();
+    testGroundTruth();
+    if (failures > 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all interpolator checks passed\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Torn-read test for the shared-memory seqlock: a writer thread publishes
+// updates in tight bursts while a reader with its own mapping copies them
+// out:
+//
+//     ecocar-shm-test [--seconds 2]
+//
+// Update k gives every slot the value and timestamp k, marks every slot
+// stale on odd k, and publishes a status with uptime and message rate k.
+// The writer pauses briefly after every burst so the reader gets through
+// on any number of cores. A snapshot mixing two updates fails the test, as
+// does a reader that gets fewer than MIN_READS_PER_SECOND through or never
+// sees the stale flag.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "shmsnapshot.h"
+
+namespace {
+
+const int BURST_WRITES = 63;  // Odd, so pauses alternate between stale and fresh
+const int PAUSE_US = 50;
+const long MIN_READS_PER_SECOND = 1000;
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int seconds = 2;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--seconds") == 0) {
+            seconds = std::max(1, std::atoi(argv[i + 1]));
+        }
+    }
+
+    const SignalSchema &schema = SignalSchema::vehicle();
+    const std::string name = "/ecocar-hmi-test-" + std::to_string(getpid());
+    ShmSnapshotWriter writer(schema);
+    if (!writer.create(name.c_str())) {
+        std::perror("shm_open");
+        return 1;
+    }
+    ShmSnapshotReader reader(schema);
+    if (!reader.attach(name.c_str())) {
+        std::fprintf(stderr, "cannot attach to %s\n", name.c_str());
+        return 1;
+    }
+
+    std::atomic<bool> done(false);
+    std::int64_t writes = 0;
+    std::thread writerThread([&] {
+        auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+        while (std::chrono::steady_clock::now() < end) {
+            ++writes;
+            SignalSample sample;
+            sample.value = double(writes);
+            sample.timestamp = writes;
+            sample.valid = true;
+            sample.stale = writes % 2 != 0;
+            SystemStatus status;
+            status.connected = true;
+            status.uptime = writes;
+            status.messageRate = double(writes);
+
+            writer.beginUpdate();
+            for (int i = 0; i < schema.size(); ++i) {
+                writer.setSample(i, sample);
+            }
+            writer.setStatus(status);
+            writer.endUpdate();
+            if (writes % BURST_WRITES == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(PAUSE_US));
+            }
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    SignalTable table(schema.size());
+    SystemStatus status;
+    long reads = 0;
+    long busy = 0;
+    long torn = 0;
+    long staleReads = 0;
+    std::int64_t last = 0;
+    while (!done.load(std::memory_order_acquire)) {
+        bool statusUpdated = false;
+        ShmSnapshotReader::Result result = reader.read(table, status, statusUpdated);
+        if (result == ShmSnapshotReader::Busy) {
+            ++busy;
+            continue;
+        }
+        if (result != ShmSnapshotReader::Updated) {
+            continue;
+        }
+        table.commit();
+        ++reads;
+
+        // Timestamp 0 is the segment as created: all zero and not valid
+        const SignalSample &first = table.at(0);
+        bool mixed = first.timestamp < last || first.value != double(first.timestamp)
+                     || first.valid != (first.timestamp != 0)
+                     || first.stale != (first.timestamp % 2 != 0);
+        for (int i = 1; i < schema.size() && !mixed; ++i) {
+            const SignalSample &sample = table.at(i);
+            mixed = sample.value != first.value || sample.timestamp != first.timestamp
+                    || sample.valid != first.valid || sample.stale != first.stale;
+        }
+        if (statusUpdated) {
+            mixed = mixed || status.uptime != first.timestamp
+                    || status.messageRate != double(first.timestamp);
+        }
+        if (mixed) {
+            ++torn;
+        }
+        if (first.stale) {
+            ++staleReads;
+        }
+        last = first.timestamp;
+    }
+    writerThread.join();
+
+    std::printf("writes %lld, reads %ld (%ld stale), busy %ld, retries %llu, torn %ld\n",
+                static_cast<long long>(writes), reads, staleReads, busy,
+                static_cast<unsigned long long>(reader.retries()), torn);
+    if (reads < MIN_READS_PER_SECOND * seconds) {
+        std::fprintf(stderr, "reader got only %ld reads through\n", reads);
+        return 1;
+    }
+    if (staleReads == 0) {
+        std::fprintf(stderr, "reader never saw an update with the stale flag\n");
+        return 1;
+    }
+    return torn == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+// Stress test for TripleBuffer: one writer publishes states as fast as it
+// can while one reader takes them, both on their own threads:
+//
+//     ecocar-triplebuffer-test [--seconds 2]
+//
+// Every state the reader sees must be whole, with all values from the same
+// publish, and sequences must never go backwards. Every other state is
+// filled in place with yields, so the reader often runs mid-write.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "triplebuffer.h"
+
+namespace {
+
+const int VALUE_COUNT = 64;
+
+struct State {
+    std::vector<double> values;
+    unsigned long long sequence = 0;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int seconds = 2;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--seconds") == 0) {
+            seconds = std::max(1, std::atoi(argv[i + 1]));
+        }
+    }
+
+    TripleBuffer<State> buffer;
+    std::atomic<bool> done(false);
+    unsigned long long writes = 0;
+
+    std::thread writer([&] {
+        auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+        for (unsigned long long sequence = 1; std::chrono::steady_clock::now() < end;
+             ++sequence) {
+            State &back = buffer.writeBuffer();
+            back.sequence = sequence;
+            back.values.resize(VALUE_COUNT);
+            for (int i = 0; i < VALUE_COUNT; ++i) {
+                back.values[i] = double(sequence);
+                if (sequence % 2 == 0 && i % 16 == 15) {
+                    std::this_thread::yield();
+                }
+            }
+            buffer.publish();
+            ++writes;
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    unsigned long long reads = 0;
+    unsigned long long torn = 0;
+    unsigned long long backwards = 0;
+    unsigned long long last = 0;
+    while (!done.load(std::memory_order_acquire)) {
+        if (!buffer.update()) {
+            std::this_thread::yield();
+            continue;
+        }
+        const State &state = buffer.readBuffer();
+        ++reads;
+        if (state.sequence <= last) {
+            ++backwards;
+        }
+        last = state.sequence;
+        if (state.values.size() != std::size_t(VALUE_COUNT)) {
+            ++torn;
+            continue;
+        }
+        for (double value : state.values) {
+            if (value != double(state.sequence)) {
+                ++torn;
+                break;
+            }
+        }
+    }
+    writer.join();
+
+    std::printf("writes %llu, reads %llu, torn %llu, out of order %llu\n",
+                writes, reads, torn, backwards);
+    if (reads == 0) {
+        std::fprintf(stderr, "reader never saw a published state\n");
+        return 1;
+    }
+    return torn == 0 && backwards == 0 ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+// Compares CanDecoder, whose layouts are compiled in from the DBC, with a
+// generic decoder that reads the same layouts from a table at run time and
+// finds messages by binary search, as a DBC library loading the file would:
+//
+//     ecocar-can-bench [--frames 1000000] [--rounds 20]
+//
+// Both decode the same random frames into a SignalTable, committing every
+// 64 frames like a recvmmsg() batch, and must agree on every value.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "candecoder.h"
+
+namespace {
+
+const int BATCH_SIZE = 64;
+
+struct RuntimeSignal {
+    int start;
+    int length;
+    bool bigEndian;
+    bool isSigned;
+    double factor;
+    double offset;
+    int slot;
+    int validity;  // Index into the message's signals, or -1
+    bool isFlag;
+};
+
+struct RuntimeMessage {
+    std::uint32_t id;
+    int minLength;
+    std::vector<RuntimeSignal> signalList;
+};
+
+std::uint64_t extractBits(const std::uint8_t *data, const RuntimeSignal &signal)
+{
+    int msb = signal.bigEndian ? signal.start / 8 * 8 + 7 - signal.start % 8 : 0;
+    int first = signal.start / 8;
+    int last = signal.bigEndian ? (msb + signal.length - 1) / 8
+                                : (signal.start + signal.length - 1) / 8;
+    std::uint64_t word = 0;
+    if (signal.bigEndian) {
+        for (int i = first; i <= last; ++i) {
+            word = word << 8 | data[i];
+        }
+        word >>= 7 - (msb + signal.length - 1) % 8;
+    } else {
+        for (int i = last; i >= first; --i) {
+            word = word << 8 | data[i];
+        }
+        word >>= signal.start % 8;
+    }
+    return signal.length == 64 ? word : word & ((std::uint64_t(1) << signal.length) - 1);
+}
+
+int lastByte(const RuntimeSignal &signal)
+{
+    if (signal.bigEndian) {
+        return (signal.start / 8 * 8 + 7 - signal.start % 8 + signal.length - 1) / 8;
+    }
+    return (signal.start + signal.length - 1) / 8;
+}
+
+// Everything the compiled decoder fixes at compile time, read from the
+// generated types into plain data
+template<typename Msg, std::size_t... I>
+RuntimeMessage describe(const SignalSchema &schema, std::index_sequence<I...>)
+{
+    RuntimeMessage message{Msg::id, Msg::minLength, {}};
+    (message.signalList.push_back(
+             {std::tuple_element_t<I, typename Msg::Signals>::start,
+              std::tuple_element_t<I, typename Msg::Signals>::bitLength,
+              std::tuple_element_t<I, typename Msg::Signals>::order == ByteOrder::BigEndian,
+              std::tuple_element_t<I, typename Msg::Signals>::isSigned,
+              std::tuple_element_t<I, typename Msg::Signals>::factor,
+              std::tuple_element_t<I, typename Msg::Signals>::offset,
+              schema.indexOf(std::tuple_element_t<I, typename Msg::Signals>::key),
+              std::tuple_element_t<I, typename Msg::Signals>::validity,
+              std::tuple_element_t<I, typename Msg::Signals>::validates >= 0}), ...);
+    return message;
+}
+
+template<std::size_t... M>
+std::vector<RuntimeMessage> describeAll(const SignalSchema &schema, std::index_sequence<M...>)
+{
+    using Messages = candbc::Messages;
+    std::vector<RuntimeMessage> messages = {describe<std::tuple_element_t<M, Messages>>(
+            schema, std::make_index_sequence<
+                    std::tuple_size_v<typename std::tuple_element_t<M, Messages>::Signals>>())...};
+    std::sort(messages.begin(), messages.end(),
+              [](const RuntimeMessage &a, const RuntimeMessage &b) { return a.id < b.id; });
+    return messages;
+}
+
+class RuntimeDecoder {
+public:
+    explicit RuntimeDecoder(const SignalSchema &schema)
+        : messages(describeAll(schema, std::make_index_sequence<candbc::MESSAGE_COUNT>()))
+    {
+    }
+
+    CanDecoder::Result decode(std::uint32_t id, const std::uint8_t *data, int length,
+                              std::int64_t timestamp, SignalTable &table) const
+    {
+        auto found = std::lower_bound(messages.begin(), messages.end(), id,
+                                      [](const RuntimeMessage &m, std::uint32_t value) {
+                                          return m.id < value;
+                                      });
+        if (found == messages.end() || found->id != id) {
+            return CanDecoder::Ignored;
+        }
+        if (length < found->minLength) {
+            return CanDecoder::Malformed;
+        }
+        for (const RuntimeSignal &signal : found->signalList) {
+            if (signal.isFlag || signal.slot < 0 || length <= lastByte(signal)) {
+                continue;
+            }
+            bool valid = true;
+            if (signal.validity >= 0) {
+                const RuntimeSignal &flag = found->signalList[signal.validity];
+                valid = length <= lastByte(flag) || extractBits(data, flag) != 0;
+            }
+            std::uint64_t bits = extractBits(data, signal);
+            std::int64_t raw = std::int64_t(bits);
+            if (signal.isSigned && signal.length < 64) {
+                std::uint64_t sign = std::uint64_t(1) << (signal.length - 1);
+                raw = std::int64_t((bits ^ sign) - sign);
+            }
+            SignalSample &sample = table.stage(signal.slot);
+            sample.value = double(raw) * signal.factor + signal.offset;
+            sample.timestamp = timestamp;
+            sample.valid = valid;
+            sample.stale = false;
+        }
+        return CanDecoder::Decoded;
+    }
+
+private:
+    std::vector<RuntimeMessage> messages;
+};
+
+struct Frame {
+    std::uint32_t id;
+    int length;
+    std::uint8_t data[8];
+};
+
+template<typename Decoder>
+double run(const Decoder &decoder, const std::vector<Frame> &frames, int rounds,
+           SignalTable &table, double &checksum)
+{
+    using namespace std::chrono;
+    auto begin = steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (std::size_t i = 0; i < frames.size(); ++i) {
+            const Frame &frame = frames[i];
+            decoder.decode(frame.id, frame.data, frame.length, std::int64_t(i), table);
+            if (i % BATCH_SIZE == BATCH_SIZE - 1) {
+                table.commit();
+            }
+        }
+        table.commit();
+    }
+    auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - begin).count();
+    for (int slot = 0; slot < table.size(); ++slot) {
+        checksum += table.at(slot).value;
+    }
+    return double(elapsed) / double(frames.size()) / rounds;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::size_t frameCount = 1000000;
+    int rounds = 20;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--frames") == 0) {
+            frameCount = std::size_t(std::atol(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--rounds") == 0) {
+            rounds = std::max(1, std::atoi(argv[i + 1]));
+        }
+    }
+
+    const SignalSchema &schema = SignalSchema::vehicle();
+    CanDecoder compiled(schema);
+    RuntimeDecoder runtime(schema);
+
+    // Full-length frames of every message, in random order
+    std::mt19937 random(1);
+    std::vector<Frame> frames(frameCount);
+    for (Frame &frame : frames) {
+        int message = int(random() % candbc::MESSAGE_COUNT);
+        frame.id = candbc::MESSAGE_IDS[message];
+        frame.length = 8;
+        for (std::uint8_t &byte : frame.data) {
+            byte = std::uint8_t(random());
+        }
+    }
+
+    // Same frames, same table contents, including short frames
+    SignalTable expected(schema.size());
+    SignalTable actual(schema.size());
+    for (std::size_t i = 0; i < std::min<std::size_t>(frames.size(), 100000); ++i) {
+        Frame frame = frames[i];
+        frame.length = int(i % 9);
+        if (compiled.decode(frame.id, frame.data, frame.length, 0, actual)
+                != runtime.decode(frame.id, frame.data, frame.length, 0, expected)) {
+            std::fprintf(stderr, "results differ for frame %zu\n", i);
+            return 1;
+        }
+        actual.commit();
+        expected.commit();
+        for (int slot = 0; slot < schema.size(); ++slot) {
+            if (actual.at(slot).value != expected.at(slot).value
+                    || actual.at(slot).valid != expected.at(slot).valid) {
+                std::fprintf(stderr, "values differ for frame %zu\n", i);
+                return 1;
+            }
+        }
+    }
+
+    double checksum = 0.0;
+    double runtimeNs = run(runtime, frames, rounds, expected, checksum);
+    double compiledNs = run(compiled, frames, rounds, actual, checksum);
+    std::printf("runtime layouts:  %6.2f ns/frame\n", runtimeNs);
+    std::printf("compiled layouts: %6.2f ns/frame (%.1fx)\n", compiledNs, runtimeNs / compiledNs);
+    std::printf("checksum %g\n", checksum);
+    return 0;
+}
@@ -0,0 +1,254 @@
+// Compares reading a SocketCAN interface one read() per frame, committing
+// every frame, with CanSocket's recvmmsg() batches of up to 64 frames
+// committed once per batch:
+//
+//     ecocar-can-read-bench [--interface vcan0] [--seconds 5]
+//
+// A writer thread floods the interface with frames of the DBC's messages
+// while the reader decodes them into a SignalTable, and for each mode the
+// frames received per second, the reader's CPU per frame and the frames per
+// system call are reported. Frames the reader fell behind on are dropped by
+// the kernel and show up as sent but not received. Needs an interface that
+// is up, such as vcan0:
+//
+//     sudo modprobe vcan
+//     sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "candecoder.h"
+
+namespace {
+
+const int BATCH_SIZE = 64;  // As CanSocket
+const int FRAME_POOL = 4096;
+const int RECEIVE_TIMEOUT_MS = 100;
+
+struct Result {
+    std::uint64_t sent = 0;
+    std::uint64_t received = 0;
+    std::uint64_t calls = 0;
+    double seconds = 0.0;
+    double cpuSeconds = 0.0;
+};
+
+// This thread's user plus system time
+double threadCpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+           + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// A raw socket bound to `interfaceName`, passing only `filters`; none
+// passes nothing, for a socket that only writes
+int openSocket(const std::string &interfaceName, const std::vector<can_filter> &filters)
+{
+    int fd = socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ifreq request;
+    std::memset(&request, 0, sizeof(request));
+    std::strncpy(request.ifr_name, interfaceName.c_str(), IFNAMSIZ - 1);
+    sockaddr_can address;
+    std::memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    timeval timeout = {0, RECEIVE_TIMEOUT_MS * 1000};
+    if (ioctl(fd, SIOCGIFINDEX, &request) < 0
+            || setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(),
+                          socklen_t(filters.size() * sizeof(can_filter))) < 0
+            || setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0) {
+        close(fd);
+        return -1;
+    }
+    address.can_ifindex = request.ifr_ifindex;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void writeFrames(int fd, const std::vector<can_frame> &frames, double seconds,
+                 std::atomic<bool> &writing, std::uint64_t &sent)
+{
+    using namespace std::chrono;
+    auto end = steady_clock::now() + duration_cast<steady_clock::duration>(
+                                         duration<double>(seconds));
+    std::size_t next = 0;
+    while (steady_clock::now() < end) {
+        if (write(fd, &frames[next], sizeof(can_frame)) == ssize_t(sizeof(can_frame))) {
+            ++sent;
+            next = (next + 1) % frames.size();
+        } else if (errno == ENOBUFS || errno == EINTR) {
+            std::this_thread::yield();  // Transmit queue full
+        } else {
+            std::perror("write");
+            break;
+        }
+    }
+    writing = false;
+}
+
+// Reads and decodes until the writer is done and the socket stays quiet
+void readFrames(int fd, bool batched, const std::atomic<bool> &writing, Result &result)
+{
+    const SignalSchema &schema = SignalSchema::vehicle();
+    const CanDecoder decoder(schema);
+    SignalTable table(schema.size());
+
+    can_frame frames[BATCH_SIZE];
+    iovec vectors[BATCH_SIZE];
+    mmsghdr messages[BATCH_SIZE];
+    std::memset(messages, 0, sizeof(messages));
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        vectors[i].iov_base = &frames[i];
+        vectors[i].iov_len = sizeof(can_frame);
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    using namespace std::chrono;
+    auto begin = steady_clock::now();
+    auto last = begin;
+    double cpuBefore = threadCpuSeconds();
+    double cpuLast = cpuBefore;
+    for (;;) {
+        int received;
+        if (batched) {
+            // Blocks for the first frame, then takes whatever else is queued
+            received = recvmmsg(fd, messages, BATCH_SIZE, MSG_WAITFORONE, nullptr);
+        } else {
+            ssize_t bytes = read(fd, &frames[0], sizeof(can_frame));
+            received = bytes < 0 ? -1 : int(bytes == ssize_t(sizeof(can_frame)));
+        }
+        if (received < 0) {
+            if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && writing)) {
+                continue;
+            }
+            break;
+        }
+        ++result.calls;
+
+        bool decoded = false;
+        for (int i = 0; i < received; ++i) {
+            const can_frame &frame = frames[i];
+            if (decoder.decode(frame.can_id & CAN_SFF_MASK, frame.data,
+                               std::min<int>(frame.can_dlc, CAN_MAX_DLEN), 0, table)
+                    == CanDecoder::Decoded) {
+                decoded = true;
+            }
+        }
+        if (decoded) {
+            table.commit();
+        }
+        result.received += std::uint64_t(received);
+        last = steady_clock::now();
+        cpuLast = threadCpuSeconds();
+    }
+    result.seconds = duration<double>(last - begin).count();
+    result.cpuSeconds = cpuLast - cpuBefore;
+}
+
+bool run(const std::string &interfaceName, bool batched, double seconds,
+         const std::vector<can_frame> &frames, Result &result)
+{
+    std::vector<can_filter> filters;
+    for (std::uint32_t id : CanDecoder::messageIds()) {
+        can_filter filter;
+        filter.can_id = id & CAN_SFF_MASK;
+        filter.can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        filters.push_back(filter);
+    }
+    int reader = openSocket(interfaceName, filters);
+    int writer = openSocket(interfaceName, {});
+    if (reader < 0 || writer < 0) {
+        std::fprintf(stderr, "cannot open %s: %s\n", interfaceName.c_str(),
+                     std::strerror(errno));
+        if (reader >= 0) {
+            close(reader);
+        }
+        if (writer >= 0) {
+            close(writer);
+        }
+        return false;
+    }
+
+    std::atomic<bool> writing(true);
+    std::thread thread(writeFrames, writer, std::cref(frames), seconds, std::ref(writing),
+                       std::ref(result.sent));
+    readFrames(reader, batched, writing, result);
+    thread.join();
+    close(reader);
+    close(writer);
+    return result.received > 0;
+}
+
+void report(const char *mode, const Result &result)
+{
+    std::printf("%10s  %10llu  %10llu  %10.0f  %12.1f  %11.1f\n", mode,
+                static_cast<unsigned long long>(result.sent),
+                static_cast<unsigned long long>(result.received),
+                double(result.received) / std::max(result.seconds, 1e-9),
+                result.cpuSeconds / double(result.received) * 1e9,
+                double(result.received) / double(std::max<std::uint64_t>(result.calls, 1)));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string interfaceName = "vcan0";
+    double seconds = 5.0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--interface") == 0) {
+            interfaceName = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            seconds = std::max(0.1, std::atof(argv[i + 1]));
+        }
+    }
+
+    // Full-length frames of every message, in random order
+    const std::vector<std::uint32_t> &ids = CanDecoder::messageIds();
+    std::mt19937 random(1);
+    std::vector<can_frame> frames(FRAME_POOL);
+    for (can_frame &frame : frames) {
+        std::memset(&frame, 0, sizeof(frame));
+        frame.can_id = ids[random() % ids.size()];
+        frame.can_dlc = CAN_MAX_DLEN;
+        for (std::uint8_t &byte : frame.data) {
+            byte = std::uint8_t(random());
+        }
+    }
+
+    std::printf("%s, %.1f s per mode\n", interfaceName.c_str(), seconds);
+    std::printf("%10s  %10s  %10s  %10s  %12s  %11s\n", "mode", "sent", "received", "frames/s",
+                "cpu (ns)", "frames/call");
+    for (bool batched : {false, true}) {
+        Result result;
+        if (!run(interfaceName, batched, seconds, frames, result)) {
+            return 1;
+        }
+        report(batched ? "recvmmsg" : "read", result);
+    }
+    return 0;
+}
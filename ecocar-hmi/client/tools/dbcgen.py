@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""Generates compile-time CAN decoders from a DBC file.
+
+Every message becomes a struct holding one CanSignal type per signal
+(src/cansignal.h), so bit positions, byte order, sign and scaling are all
+template arguments or constants. Message IDs get a perfect hash, so
+dispatch is one multiply, one shift and one table load. Run by the build:
+
+    python3 dbcgen.py can/ecocar.dbc build/generated/candbc.h
+
+Signal names are client schema keys. A signal named <key>_valid is the
+validity flag of <key> in the same message. Multiplexed signals and
+extended (29-bit) IDs are not supported. Only the standard library is used.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+MESSAGE_RE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+SIGNAL_RE = re.compile(
+    r'^SG_\s+(\w+)\s*(\S*)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+    r'\(\s*([-+0-9.eE]+)\s*,\s*([-+0-9.eE]+)\s*\)')
+
+EXTENDED_FLAG = 0x80000000
+MAX_HASH_TRIES = 100000
+
+
+class DbcError(Exception):
+    pass
+
+
+def parse(path):
+    messages = []
+    with open(path, encoding='utf-8') as dbc:
+        for number, line in enumerate(dbc, 1):
+            line = line.strip()
+            match = MESSAGE_RE.match(line)
+            if match:
+                frame_id = int(match.group(1))
+                if frame_id & EXTENDED_FLAG:
+                    raise DbcError(f'{path}:{number}: extended ID not supported')
+                messages.append({
+                    'id': frame_id,
+                    'name': match.group(2),
+                    'length': int(match.group(3)),
+                    'signals': [],
+                })
+                continue
+            if not line.startswith('SG_'):
+                continue
+            match = SIGNAL_RE.match(line)
+            if not match or not messages:
+                raise DbcError(f'{path}:{number}: cannot parse signal')
+            if match.group(2):
+                raise DbcError(f'{path}:{number}: multiplexed signal not supported')
+            signal = {
+                'name': match.group(1),
+                'start': int(match.group(3)),
+                'length': int(match.group(4)),
+                'big_endian': match.group(5) == '0',
+                'signed': match.group(6) == '-',
+                'factor': float(match.group(7)),
+                'offset': float(match.group(8)),
+            }
+            check_layout(path, number, messages[-1], signal)
+            messages[-1]['signals'].append(signal)
+
+    if not messages:
+        raise DbcError(f'{path}: no messages')
+    ids = [message['id'] for message in messages]
+    if len(set(ids)) != len(ids):
+        raise DbcError(f'{path}: duplicate message ID')
+    for message in messages:
+        link_validity(path, message)
+    return messages
+
+
+def byte_span(signal):
+    """First and last byte a signal occupies"""
+    start, length = signal['start'], signal['length']
+    if signal['big_endian']:
+        # Start is the MSB; count bits from the MSB of byte 0 downwards
+        msb = start // 8 * 8 + 7 - start % 8
+        return start // 8, (msb + length - 1) // 8
+    return start // 8, (start + length - 1) // 8
+
+
+def check_layout(path, number, message, signal):
+    first, last = byte_span(signal)
+    if not 0 < signal['length'] <= 64 or last - first >= 8:
+        raise DbcError(f'{path}:{number}: signal wider than 64 bits')
+    if last >= message['length']:
+        raise DbcError(f'{path}:{number}: signal beyond the message length')
+
+
+def link_validity(path, message):
+    names = [signal['name'] for signal in message['signals']]
+    for signal in message['signals']:
+        signal['validity'] = -1
+        signal['validates'] = -1
+    for index, signal in enumerate(message['signals']):
+        if signal['name'].endswith('_valid'):
+            target = signal['name'][:-len('_valid')]
+            if target in names:
+                signal['validates'] = names.index(target)
+                message['signals'][names.index(target)]['validity'] = index
+    if all(signal['validates'] >= 0 for signal in message['signals']):
+        raise DbcError(f"{path}: {message['name']} has no value signals")
+
+
+def perfect_hash(ids):
+    """Multiplier and shift giving each ID its own slot in a power-of-two
+    table: slot = (id * multiplier mod 2^32) >> shift"""
+    bits = max(1, (len(ids) - 1).bit_length())
+    while bits <= 16:
+        shift = 32 - bits
+        multiplier = 0x9E3779B1  # Golden ratio; then a fixed odd sequence
+        for _ in range(MAX_HASH_TRIES):
+            slots = {(frame_id * multiplier & 0xFFFFFFFF) >> shift for frame_id in ids}
+            if len(slots) == len(ids):
+                return multiplier, shift, 1 << bits
+            multiplier = (multiplier * 0x2C9277B5 + 0xAC564B05) & 0xFFFFFFFF | 1
+        bits += 1
+    raise DbcError('no perfect hash found')
+
+
+def camel_case(name):
+    return ''.join(part[:1].upper() + part[1:].lower() for part in name.split('_') if part)
+
+
+def cpp_double(value):
+    text = repr(float(value))
+    return text if ('.' in text or 'e' in text) else text + '.0'
+
+
+def generate(messages, source):
+    ids = [message['id'] for message in messages]
+    multiplier, shift, size = perfect_hash(ids)
+    slots = [-1] * size
+    for index, frame_id in enumerate(ids):
+        slots[(frame_id * multiplier & 0xFFFFFFFF) >> shift] = index
+
+    out = []
+    emit = out.append
+    emit(f'// Generated by tools/dbcgen.py from {source}; do not edit.')
+    emit('#ifndef CANDBC_H')
+    emit('#define CANDBC_H')
+    emit('')
+    emit('#include <cstdint>')
+    emit('#include <tuple>')
+    emit('#include "cansignal.h"')
+    emit('')
+    emit('enum class MessageID : std::uint32_t {')
+    for message in messages:
+        emit(f"    {message['name']} = 0x{message['id']:X},")
+    emit('};')
+    emit('')
+    emit('namespace candbc {')
+    emit('')
+
+    first_signal = 0
+    for message in messages:
+        emit(f"struct {camel_case(message['name'])}Message {{")
+        emit(f"    static constexpr std::uint32_t id = 0x{message['id']:X};")
+        emit(f"    static constexpr int length = {message['length']};")
+        value_bytes = [byte_span(signal)[1] + 1 for signal in message['signals']
+                       if signal['validates'] < 0]
+        emit(f'    static constexpr int minLength = {min(value_bytes)};  // Shorter is malformed')
+        emit(f'    static constexpr int firstSignal = {first_signal};  // In SIGNAL_KEYS')
+        emit('')
+        for signal in message['signals']:
+            order = 'BigEndian' if signal['big_endian'] else 'LittleEndian'
+            signed = 'true' if signal['signed'] else 'false'
+            emit(f"    struct {camel_case(signal['name'])} : CanSignal<{signal['start']}, "
+                 f"{signal['length']}, ByteOrder::{order}, {signed}> {{")
+            emit(f"        static constexpr const char *key = \"{signal['name']}\";")
+            emit(f"        static constexpr double factor = {cpp_double(signal['factor'])};")
+            emit(f"        static constexpr double offset = {cpp_double(signal['offset'])};")
+            emit(f"        static constexpr int validity = {signal['validity']};")
+            emit(f"        static constexpr int validates = {signal['validates']};")
+            emit('    };')
+        names = ', '.join(camel_case(signal['name']) for signal in message['signals'])
+        emit(f'    using Signals = std::tuple<{names}>;')
+        emit('};')
+        emit('')
+        first_signal += len(message['signals'])
+
+    names = ', '.join(camel_case(message['name']) + 'Message' for message in messages)
+    emit(f'using Messages = std::tuple<{names}>;')
+    emit('')
+    emit(f'constexpr int SIGNAL_COUNT = {first_signal};')
+    emit('constexpr const char *SIGNAL_KEYS[SIGNAL_COUNT] = {')
+    for message in messages:
+        keys = ', '.join(f"\"{signal['name']}\"" for signal in message['signals'])
+        emit(f'    {keys},')
+    emit('};')
+    emit('')
+    emit(f'constexpr int MESSAGE_COUNT = {len(messages)};')
+    emit('constexpr std::uint32_t MESSAGE_IDS[MESSAGE_COUNT] = {')
+    emit('    ' + ', '.join(f'0x{frame_id:X}' for frame_id in ids) + ',')
+    emit('};')
+    emit('')
+    emit('// Perfect hash of MESSAGE_IDS: each lands in its own slot of a')
+    emit('// HASH_SIZE table, which HASH_SLOTS maps back to its index in Messages')
+    emit(f'constexpr std::uint32_t HASH_MULTIPLIER = 0x{multiplier:08X}u;')
+    emit(f'constexpr int HASH_SHIFT = {shift};')
+    emit(f'constexpr int HASH_SIZE = {size};')
+    emit('constexpr int HASH_SLOTS[HASH_SIZE] = {')
+    emit('    ' + ', '.join(str(slot) for slot in slots) + ',')
+    emit('};')
+    emit('')
+    emit('constexpr std::uint32_t hashSlot(std::uint32_t id)')
+    emit('{')
+    emit('    return (id * HASH_MULTIPLIER) >> HASH_SHIFT;')
+    emit('}')
+    emit('')
+    emit('} // namespace candbc')
+    emit('')
+    emit('#endif // CANDBC_H')
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('dbc')
+    parser.add_argument('output')
+    args = parser.parse_args()
+
+    try:
+        header = generate(parse(args.dbc), os.path.basename(args.dbc))
+    except (DbcError, OSError) as error:
+        print(f'dbcgen: {error}', file=sys.stderr)
+        return 1
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, 'w', encoding='utf-8') as output:
+        output.write(header)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,236 @@
+// Compares PayloadDecoder with decoding through a QJsonDocument or
+// QCborValue tree and looking every schema key up by name, as the client
+// did before the schema-indexed table:
+//
+//     ecocar-payload-bench [--rounds 200000]
+//
+// Each runs on can/snapshot payloads carrying 3, 50 and 500 signals, in
+// JSON and CBOR, and both must stage the same values. `--rounds` is
+// divided by the signal count, so every size decodes about as many
+// signals in total.
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCborMap>
+#include <QtCore/QCborValue>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonValue>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "payloaddecoder.h"
+
+namespace {
+
+const int SIGNAL_COUNTS[] = {3, 50, 500};
+const std::int64_t TIMESTAMP_MS = 1700000000000;
+
+// The vehicle's own keys first, then made-up ones
+std::vector<std::string> makeKeys(int count)
+{
+    const SignalSchema &vehicle = SignalSchema::vehicle();
+    std::vector<std::string> keys;
+    for (int i = 0; i < count; ++i) {
+        char key[32];
+        std::snprintf(key, sizeof(key), "signal_%03d", i);
+        keys.push_back(i < vehicle.size() ? vehicle.at(i).key : key);
+    }
+    return keys;
+}
+
+std::vector<SignalDef> makeDefs(const std::vector<std::string> &keys)
+{
+    std::vector<SignalDef> defs;
+    for (const std::string &key : keys) {
+        defs.push_back({key.c_str(), ""});
+    }
+    return defs;
+}
+
+// A SignalSchema of any size, with the key strings it points into
+struct Schema {
+    explicit Schema(int count)
+        : keys(makeKeys(count))
+        , defs(makeDefs(keys))
+        , schema(defs.data(), count)
+    {
+    }
+
+    Schema(const Schema &) = delete;
+    Schema &operator=(const Schema &) = delete;
+
+    const std::vector<std::string> keys;
+    const std::vector<SignalDef> defs;
+    const SignalSchema schema;
+};
+
+QJsonObject snapshot(const Schema &schema, double base)
+{
+    QJsonObject messages;
+    for (std::size_t i = 0; i < schema.keys.size(); ++i) {
+        QJsonObject message;
+        message.insert("value", base + double(i) * 0.25);
+        message.insert("unit", "km/h");
+        message.insert("timestamp", double(TIMESTAMP_MS + qint64(i)));
+        message.insert("is_stale", false);
+        messages.insert(QString::fromStdString(schema.keys[i]), message);
+    }
+    QJsonObject latest;
+    latest.insert("timestamp", double(TIMESTAMP_MS));
+    latest.insert("seq", 42);
+    latest.insert("epoch", "1a2b");
+    latest.insert("since", 0);
+    latest.insert("full", true);
+    latest.insert("messages", messages);
+
+    QJsonObject status;
+    status.insert("connected", true);
+    status.insert("uptime", 3600);
+    status.insert("message_rate", 100.0);
+    status.insert("error_count", 0);
+
+    QJsonObject root;
+    root.insert("latest", latest);
+    root.insert("status", status);
+    return root;
+}
+
+// QJsonValue has a single number type; CBOR keeps integers apart
+bool isNumber(const QJsonValue &value)
+{
+    return value.isDouble();
+}
+
+bool isNumber(const QCborValue &value)
+{
+    return value.isDouble() || value.isInteger();
+}
+
+// The tree-based decoders: parse everything, then find each schema key by
+// name. `Tree` is QJsonObject or QCborMap.
+template<typename Tree>
+void stageMessages(const Tree &messages, const Schema &schema, SignalTable &table)
+{
+    for (std::size_t i = 0; i < schema.keys.size(); ++i) {
+        const auto message = messages.value(QLatin1String(schema.keys[i].c_str()));
+        if (message.isUndefined()) {
+            continue;
+        }
+        SignalSample &sample = table.stage(int(i));
+        const auto value = message[QLatin1String("value")];
+        sample.valid = isNumber(value);
+        sample.value = value.toDouble();
+        sample.timestamp = std::int64_t(message[QLatin1String("timestamp")].toDouble());
+        sample.stale = message[QLatin1String("is_stale")].toBool();
+    }
+}
+
+bool decodeJsonTree(const QByteArray &payload, const Schema &schema, SignalTable &table)
+{
+    QJsonDocument document = QJsonDocument::fromJson(payload);
+    if (!document.isObject()) {
+        return false;
+    }
+    const QJsonObject root = document.object();
+    const QJsonObject latest = root.value(QLatin1String("latest")).toObject();
+    stageMessages(latest.value(QLatin1String("messages")).toObject(), schema, table);
+    return true;
+}
+
+bool decodeCborTree(const QByteArray &payload, const Schema &schema, SignalTable &table)
+{
+    QCborValue document = QCborValue::fromCbor(payload);
+    if (!document.isMap()) {
+        return false;
+    }
+    const QCborMap root = document.toMap();
+    const QCborMap latest = root.value(QLatin1String("latest")).toMap();
+    stageMessages(latest.value(QLatin1String("messages")).toMap(), schema, table);
+    return true;
+}
+
+template<typename Decode>
+double run(Decode decode, const QByteArray payloads[2], int rounds, SignalTable &table)
+{
+    using namespace std::chrono;
+    auto begin = steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        if (!decode(payloads[round % 2], table)) {
+            std::fprintf(stderr, "payload did not decode\n");
+            std::exit(1);
+        }
+        table.commit();
+    }
+    auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - begin).count();
+    return double(elapsed) / rounds / 1000.0;
+}
+
+bool sameTables(const SignalTable &a, const SignalTable &b)
+{
+    for (int slot = 0; slot < a.size(); ++slot) {
+        const SignalSample &x = a.at(slot);
+        const SignalSample &y = b.at(slot);
+        if (x.value != y.value || x.timestamp != y.timestamp || x.valid != y.valid
+                || x.stale != y.stale) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int totalRounds = 200000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--rounds") == 0) {
+            totalRounds = std::max(1, std::atoi(argv[i + 1]));
+        }
+    }
+
+    std::printf("%8s  %6s  %8s  %12s  %12s  %7s\n", "signals", "format", "bytes", "tree (us)",
+                "decoder (us)", "speedup");
+    for (int count : SIGNAL_COUNTS) {
+        const Schema schema(count);
+        const PayloadDecoder decoder(schema.schema);
+        const int rounds = std::max(2, totalRounds / count);
+        const QJsonObject snapshots[2] = {snapshot(schema, 10.5), snapshot(schema, 20.25)};
+
+        for (PayloadDecoder::Format format : {PayloadDecoder::Json, PayloadDecoder::Cbor}) {
+            const bool json = format == PayloadDecoder::Json;
+            QByteArray payloads[2];
+            for (int i = 0; i < 2; ++i) {
+                payloads[i] = json ? QJsonDocument(snapshots[i]).toJson(QJsonDocument::Compact)
+                                   : QCborValue::fromJsonValue(snapshots[i]).toCbor();
+            }
+
+            SignalTable treeTable(count);
+            SignalTable decoderTable(count);
+            auto tree = [&](const QByteArray &payload, SignalTable &table) {
+                return json ? decodeJsonTree(payload, schema, table)
+                            : decodeCborTree(payload, schema, table);
+            };
+            auto direct = [&](const QByteArray &payload, SignalTable &table) {
+                PayloadHeader header;
+                return decoder.decode(payload.constData(), std::size_t(payload.size()), format,
+                                      table, header);
+            };
+
+            double treeUs = run(tree, payloads, rounds, treeTable);
+            double decoderUs = run(direct, payloads, rounds, decoderTable);
+            if (!sameTables(treeTable, decoderTable)) {
+                std::fprintf(stderr, "decoders disagree at %d signals\n", count);
+                return 1;
+            }
+            std::printf("%8d  %6s  %8lld  %12.2f  %12.2f  %6.1fx\n", count, json ? "JSON" : "CBOR",
+                        static_cast<long long>(payloads[0].size()), treeUs, decoderUs,
+                        treeUs / decoderUs);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Stand-in for the CAN gateway's shared-memory output, so the HMI can be
+// run against shm:/ecocar-hmi without hardware:
+//
+//     ecocar-shm-standin [--name /ecocar-hmi] [--rate 100] [--dropout 2]
+//
+// Produces the same simulated signals as server/standin_server.py. The
+// motor temperature goes silent for --dropout seconds out of every
+// DROPOUT_PERIOD_S, and like the gateway the stand-in flags a signal stale
+// once it has not been updated for STALE_THRESHOLD_MS.
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "shmsnapshot.h"
+
+namespace {
+
+const std::int64_t STALE_THRESHOLD_MS = 500;
+const double DROPOUT_PERIOD_S = 20.0;
+
+volatile std::sig_atomic_t running = 1;
+
+void handleSignal(int)
+{
+    running = 0;
+}
+
+std::int64_t nowMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const char *name = "/ecocar-hmi";
+    double rate = 100.0;
+    double dropout = 2.0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--name") == 0) {
+            name = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--rate") == 0) {
+            rate = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--dropout") == 0) {
+            dropout = std::atof(argv[i + 1]);
+        }
+    }
+    if (rate <= 0.0) {
+        std::fprintf(stderr, "--rate must be positive\n");
+        return 1;
+    }
+    if (dropout < 0.0 || dropout >= DROPOUT_PERIOD_S) {
+        std::fprintf(stderr, "--dropout must be 0 to %.0f seconds\n", DROPOUT_PERIOD_S);
+        return 1;
+    }
+
+    const SignalSchema &schema = SignalSchema::vehicle();
+    ShmSnapshotWriter writer(schema);
+    if (!writer.create(name)) {
+        std::perror("shm_open");
+        return 1;
+    }
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::printf("EcoCar shared-memory stand-in on shm:%s at %.0f frames/s\n", name, rate);
+
+    const int slots[] = {schema.indexOf("speed"), schema.indexOf("battery_voltage"),
+                         schema.indexOf("motor_temp")};
+    SignalSample written[3];  // Last sample per signal, flagged stale in place
+    const auto period = std::chrono::duration<double>(1.0 / rate);
+    const std::int64_t startMs = nowMs();
+
+    SystemStatus status;
+    status.connected = true;
+    status.messageRate = rate;
+
+    double t = 0.0;
+    std::int64_t frame = 0;
+    auto next = std::chrono::steady_clock::now();
+    while (running) {
+        SignalSample sample;
+        sample.valid = true;
+        sample.timestamp = nowMs();
+
+        writer.beginUpdate();
+        // Round-robin like a real bus: one message ID per frame
+        const int signal = int(frame % 3);
+        switch (signal) {
+        case 0:
+            sample.value = std::fmax(0.0, 60.0 + 40.0 * std::sin(t / 8.0));
+            break;
+        case 1:
+            sample.value = 48.0 - 2.0 * std::sin(t / 20.0);
+            break;
+        default:
+            sample.value = 55.0 + 15.0 * std::sin(t / 30.0);
+            break;
+        }
+        bool silent = signal == 2 && std::fmod(t, DROPOUT_PERIOD_S) >= DROPOUT_PERIOD_S - dropout;
+        if (!silent) {
+            written[signal] = sample;
+            writer.setSample(slots[signal], sample);
+        }
+        for (int i = 0; i < 3; ++i) {
+            if (written[i].valid && !written[i].stale
+                    && sample.timestamp - written[i].timestamp > STALE_THRESHOLD_MS) {
+                written[i].stale = true;
+                writer.setSample(slots[i], written[i]);
+            }
+        }
+        if (frame % std::int64_t(std::ceil(rate)) == 0) {
+            status.uptime = (sample.timestamp - startMs) / 1000;
+            writer.setStatus(status);
+        }
+        writer.endUpdate();
+
+        ++frame;
+        t += period.count();
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        std::this_thread::sleep_until(next);
+    }
+    return 0;
+}
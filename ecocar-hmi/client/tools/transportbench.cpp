@@ -0,0 +1,338 @@
+// Fetches vehicle data from a running server over and over, once as JSON
+// and once as CBOR, and reports for each format the payload size, the
+// round trip, the client CPU per update and the PayloadDecoder cost:
+//
+//     ecocar-transport-bench [--server http://127.0.0.1:5000] [--requests 1000]
+//     ecocar-transport-bench --server unix:/tmp/ecocar-hmi.sock
+//
+// Each format is measured twice: an update as one can/snapshot request, as
+// the client polls, and as separate can/latest and can/status requests, as
+// it used to. Requests are sequential on one connection, like the client's
+// polls: a keep-alive HTTP connection, or LocalTransport's framing on a
+// Unix domain socket. Run both against server/standin_server.py --unix to
+// compare the transports.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <netdb.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "payloaddecoder.h"
+
+namespace {
+
+// LocalTransport's request kinds; HTTP fetches the matching path
+const char SNAPSHOT = 'P';
+const char LATEST = 'L';
+const char STATUS = 'T';
+
+const char *path(char kind)
+{
+    switch (kind) {
+    case LATEST:
+        return "/api/v1/can/latest";
+    case STATUS:
+        return "/api/v1/can/status";
+    default:
+        return "/api/v1/can/snapshot";
+    }
+}
+
+struct Result {
+    std::vector<double> roundTripsUs;  // Per update
+    double bytes = 0.0;
+    double cpuUs = 0.0;     // Per update, user plus system
+    double decodeUs = 0.0;  // Per update
+};
+
+double cpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+           + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+bool sendAll(int fd, const char *data, std::size_t size)
+{
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= std::size_t(sent);
+    }
+    return true;
+}
+
+// HTTP/1.1 with keep-alive, just enough for the stand-in's replies
+class HttpConnection {
+public:
+    HttpConnection()
+        : fd(-1)
+    {
+    }
+
+    ~HttpConnection()
+    {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool open(const std::string &host, const std::string &port)
+    {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *addresses = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+            return false;
+        }
+        for (addrinfo *address = addresses; address && fd < 0; address = address->ai_next) {
+            fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(addresses);
+        this->host = host;
+        return fd >= 0;
+    }
+
+    bool fetch(char kind, bool cbor, std::string &body)
+    {
+        std::string request = std::string("GET ") + path(kind) + " HTTP/1.1\r\nHost: " + host
+                              + "\r\nAccept: "
+                              + (cbor ? "application/cbor" : "application/json") + "\r\n\r\n";
+        if (!sendAll(fd, request.data(), request.size())) {
+            return false;
+        }
+
+        std::size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!receive()) {
+                return false;
+            }
+        }
+        std::size_t length = 0;
+        std::size_t field = buffer.find("Content-Length:");
+        if (field == std::string::npos || field > headerEnd) {
+            return false;
+        }
+        length = std::strtoul(buffer.c_str() + field + std::strlen("Content-Length:"), nullptr, 10);
+        while (buffer.size() < headerEnd + 4 + length) {
+            if (!receive()) {
+                return false;
+            }
+        }
+        body.assign(buffer, headerEnd + 4, length);
+        buffer.erase(0, headerEnd + 4 + length);
+        return true;
+    }
+
+private:
+    int fd;
+    std::string host;
+    std::string buffer;
+
+    bool receive()
+    {
+        char chunk[16384];
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, std::size_t(received));
+        return true;
+    }
+};
+
+// LocalTransport's frames: u32 big-endian length, kind, format, payload.
+// A request without a delta position gets every signal.
+class LocalConnection {
+public:
+    LocalConnection()
+        : fd(-1)
+    {
+    }
+
+    ~LocalConnection()
+    {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool open(const std::string &path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+        return fd >= 0;
+    }
+
+    bool fetch(char kind, bool cbor, std::string &body)
+    {
+        const char request[] = {0, 0, 0, 2, kind, cbor ? 'C' : 'J'};
+        if (!sendAll(fd, request, sizeof(request))) {
+            return false;
+        }
+
+        unsigned char header[6];
+        if (!receiveExact(reinterpret_cast<char *>(header), sizeof(header))) {
+            return false;
+        }
+        std::size_t length = std::size_t(header[0]) << 24 | std::size_t(header[1]) << 16
+                             | std::size_t(header[2]) << 8 | header[3];
+        if (length < 2 || header[4] != kind) {
+            return false;
+        }
+        body.resize(length - 2);
+        return receiveExact(&body[0], body.size());
+    }
+
+private:
+    int fd;
+
+    bool receiveExact(char *data, std::size_t size)
+    {
+        while (size > 0) {
+            ssize_t received = recv(fd, data, size, 0);
+            if (received <= 0) {
+                return false;
+            }
+            data += received;
+            size -= std::size_t(received);
+        }
+        return true;
+    }
+};
+
+template<typename Connection>
+bool measure(Connection &connection, bool cbor, bool split, int updates, Result &result)
+{
+    const SignalSchema &schema = SignalSchema::vehicle();
+    const PayloadDecoder decoder(schema);
+    SignalTable table(schema.size());
+    const std::vector<char> kinds = split ? std::vector<char>{LATEST, STATUS}
+                                          : std::vector<char>{SNAPSHOT};
+    std::string body;
+    double decodeSeconds = 0.0;
+    double bytes = 0.0;
+
+    result.roundTripsUs.clear();
+    double cpuBefore = cpuSeconds();
+    for (int i = 0; i < updates; ++i) {
+        using namespace std::chrono;
+        double roundTrip = 0.0;
+        for (char kind : kinds) {
+            auto sent = steady_clock::now();
+            if (!connection.fetch(kind, cbor, body)) {
+                return false;
+            }
+            auto received = steady_clock::now();
+            PayloadHeader header;
+            bool decoded = decoder.decode(body.data(), body.size(),
+                                          cbor ? PayloadDecoder::Cbor : PayloadDecoder::Json,
+                                          table, header);
+            table.commit();
+            if (!decoded) {
+                std::fprintf(stderr, "reply %d did not decode\n", i);
+                return false;
+            }
+            decodeSeconds += duration<double>(steady_clock::now() - received).count();
+            roundTrip += duration<double, std::micro>(received - sent).count();
+            bytes += double(body.size());
+        }
+        result.roundTripsUs.push_back(roundTrip);
+    }
+    result.cpuUs = (cpuSeconds() - cpuBefore) / updates * 1e6;
+    result.decodeUs = decodeSeconds / updates * 1e6;
+    result.bytes = bytes / updates;
+    return true;
+}
+
+void report(const char *format, const char *requests, Result &result)
+{
+    std::vector<double> &trips = result.roundTripsUs;
+    std::sort(trips.begin(), trips.end());
+    std::printf("%6s  %15s  %8.0f  %9.1f  %9.1f  %9.1f  %9.1f  %9.2f\n", format, requests,
+                result.bytes, trips.front(), trips[trips.size() / 2],
+                trips[trips.size() * 99 / 100], result.cpuUs, result.decodeUs);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string server = "http://127.0.0.1:5000";
+    int requests = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--server") == 0) {
+            server = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--requests") == 0) {
+            requests = std::max(1, std::atoi(argv[i + 1]));
+        }
+    }
+
+    const std::string http = "http://";
+    const std::string local = "unix:";
+    const bool isLocal = server.compare(0, local.size(), local) == 0;
+    if (!isLocal && server.compare(0, http.size(), http) != 0) {
+        std::fprintf(stderr, "--server must be http://host:port or unix:/path\n");
+        return 1;
+    }
+    std::string authority = isLocal ? "" : server.substr(http.size());
+    authority = authority.substr(0, authority.find('/'));
+    std::size_t colon = authority.rfind(':');
+    std::string host = authority.substr(0, colon);
+    std::string port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+
+    std::printf("%s, %d updates per row\n", server.c_str(), requests);
+    std::printf("%6s  %15s  %8s  %9s  %9s  %9s  %9s  %9s\n", "format", "requests", "bytes",
+                "min (us)", "p50 (us)", "p99 (us)", "cpu (us)", "decode");
+    for (int row = 0; row < 4; ++row) {
+        bool cbor = row >= 2;
+        bool split = row % 2 == 1;
+        Result result;
+        bool connected;
+        bool measured = false;
+        if (isLocal) {
+            LocalConnection connection;
+            connected = connection.open(server.substr(local.size()));
+            measured = connected && measure(connection, cbor, split, requests, result);
+        } else {
+            HttpConnection connection;
+            connected = connection.open(host, port);
+            measured = connected && measure(connection, cbor, split, requests, result);
+        }
+        if (!connected) {
+            std::fprintf(stderr, "cannot connect to %s\n", server.c_str());
+            return 1;
+        }
+        if (!measured) {
+            std::fprintf(stderr, "request to %s failed\n", server.c_str());
+            return 1;
+        }
+        report(cbor ? "CBOR" : "JSON", split ? "latest + status" : "snapshot", result);
+    }
+    return 0;
+}
@@ -0,0 +1,391 @@
+#!/usr/bin/env python3
+"""Local stand-in for the EcoCar backend.
+
+Serves the /api/v1/can endpoints from the spec with simulated CAN data so
+the HMI client can be exercised on loopback without a CAN bus or Flask.
+Only the standard library is used.
+
+    python3 standin_server.py --port 5000 --rate 100
+    python3 standin_server.py --unix /tmp/ecocar-hmi.sock
+"""
+
+import argparse
+import json
+import math
+import os
+import socketserver
+import struct
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+STALE_THRESHOLD_MS = 500
+KEEPALIVE_INTERVAL_S = 1.0
+
+
+def now_ms():
+    return int(time.time() * 1000)
+
+
+def cbor_encode(obj):
+    """Minimal RFC 8949 encoder for the types the API returns"""
+    out = bytearray()
+    _cbor_item(obj, out)
+    return bytes(out)
+
+
+def _cbor_head(major, n, out):
+    if n < 24:
+        out.append(major << 5 | n)
+    elif n < 0x100:
+        out += bytes((major << 5 | 24, n))
+    elif n < 0x10000:
+        out.append(major << 5 | 25)
+        out += n.to_bytes(2, "big")
+    elif n < 0x100000000:
+        out.append(major << 5 | 26)
+        out += n.to_bytes(4, "big")
+    else:
+        out.append(major << 5 | 27)
+        out += n.to_bytes(8, "big")
+
+
+def _cbor_item(obj, out):
+    if obj is None:
+        out.append(0xF6)
+    elif obj is True:
+        out.append(0xF5)
+    elif obj is False:
+        out.append(0xF4)
+    elif isinstance(obj, int):
+        if obj >= 0:
+            _cbor_head(0, obj, out)
+        else:
+            _cbor_head(1, -1 - obj, out)
+    elif isinstance(obj, float):
+        # Single precision when it round-trips exactly, double otherwise
+        single = struct.pack(">f", obj)
+        if struct.unpack(">f", single)[0] == obj:
+            out.append(0xFA)
+            out += single
+        else:
+            out.append(0xFB)
+            out += struct.pack(">d", obj)
+    elif isinstance(obj, str):
+        data = obj.encode()
+        _cbor_head(3, len(data), out)
+        out += data
+    elif isinstance(obj, dict):
+        _cbor_head(5, len(obj), out)
+        for key, value in obj.items():
+            _cbor_item(key, out)
+            _cbor_item(value, out)
+    elif isinstance(obj, (list, tuple)):
+        _cbor_head(4, len(obj), out)
+        for value in obj:
+            _cbor_item(value, out)
+    else:
+        raise TypeError(f"cannot CBOR-encode {type(obj).__name__}")
+
+
+class CANBuffer:
+    """Latest value per signal plus a condition for stream subscribers
+
+    Every update bumps a global sequence number and stamps the message
+    with it, so "what changed since N" is a filter on the stamp. The epoch
+    changes on restart so clients holding an old sequence resync.
+    """
+
+    def __init__(self):
+        self.messages = {}
+        self.lock = threading.Lock()
+        self.changed = threading.Condition(self.lock)
+        self.seq = 0
+        self.epoch = format(int(time.time() * 1000) & 0xFFFFFFFF, "x")
+        self.frame_count = 0
+        self.started = time.time()
+
+    def update_message(self, message_id, value, unit):
+        with self.changed:
+            self.seq += 1
+            self.messages[message_id] = {
+                "value": value,
+                "unit": unit,
+                "timestamp": now_ms(),
+                "seq": self.seq,
+            }
+            self.frame_count += 1
+            self.changed.notify_all()
+
+    def _message(self, message_id, current_ms):
+        msg = dict(self.messages[message_id])
+        msg["is_stale"] = (current_ms - msg["timestamp"]) > STALE_THRESHOLD_MS
+        return msg
+
+    def latest(self, since=None, epoch=None):
+        """Full state, or only messages changed after `since`
+
+        Falls back to a full reply when the client's sequence cannot be
+        trusted: no sequence, another epoch, or one from the future.
+        """
+        with self.lock:
+            current_ms = now_ms()
+            full = since is None or epoch != self.epoch or since > self.seq
+            keys = [k for k, v in self.messages.items()
+                    if full or v["seq"] > since]
+            return {
+                "timestamp": current_ms,
+                "seq": self.seq,
+                "epoch": self.epoch,
+                "since": 0 if full else since,
+                "full": full,
+                "messages": {k: self._message(k, current_ms) for k in keys},
+            }
+
+    def status(self):
+        with self.lock:
+            uptime = time.time() - self.started
+            return {
+                "connected": True,
+                "uptime": int(uptime),
+                "message_rate": self.frame_count / uptime if uptime > 0 else 0.0,
+                "error_count": 0,
+            }
+
+    def wait_for_change(self, seq, timeout):
+        with self.changed:
+            self.changed.wait_for(lambda: self.seq != seq, timeout)
+
+
+class SimulatedBus(threading.Thread):
+    """Produces speed, battery and motor temperature frames at a fixed rate"""
+
+    def __init__(self, buffer, rate_hz):
+        super().__init__(daemon=True)
+        self.buffer = buffer
+        self.period = 1.0 / rate_hz
+
+    def run(self):
+        t = 0.0
+        frame = 0
+        while True:
+            # Round-robin like a real bus: one message ID per frame
+            kind = frame % 3
+            if kind == 0:
+                speed = max(0.0, 60.0 + 40.0 * math.sin(t / 8.0))
+                self.buffer.update_message("speed", round(speed, 2), "km/h")
+            elif kind == 1:
+                voltage = 48.0 - 2.0 * math.sin(t / 20.0)
+                self.buffer.update_message("battery_voltage", round(voltage, 2), "V")
+            else:
+                temp = 55.0 + 15.0 * math.sin(t / 30.0)
+                self.buffer.update_message("motor_temp", round(temp, 1), "°C")
+            frame += 1
+            t += self.period
+            time.sleep(self.period)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    # Headers and body go out as separate writes; with Nagle the body
+    # waits for the client's delayed ACK of the headers, about 40 ms
+    disable_nagle_algorithm = True
+    buffer = None
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def _send_payload(self, payload, status=200):
+        # CBOR when the client asks for it, JSON otherwise
+        if "application/cbor" in self.headers.get("Accept", ""):
+            body = cbor_encode(payload)
+            content_type = "application/cbor"
+        else:
+            body = json.dumps(payload, separators=(",", ":")).encode()
+            content_type = "application/json"
+        self.send_response(status)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Vary", "Accept")
+        self.end_headers()
+        self.wfile.write(body)
+
+    def _since(self):
+        since = self.headers.get("X-Since-Seq")
+        try:
+            return int(since) if since is not None else None
+        except ValueError:
+            return None
+
+    def do_GET(self):
+        path = self.path.split("?", 1)[0]
+        since = self._since()
+        epoch = self.headers.get("X-Since-Epoch")
+        if path == "/api/v1/can/latest":
+            self._send_payload(self.buffer.latest(since, epoch))
+        elif path == "/api/v1/can/status":
+            self._send_payload(self.buffer.status())
+        elif path == "/api/v1/can/snapshot":
+            self._send_payload({"latest": self.buffer.latest(since, epoch),
+                                "status": self.buffer.status()})
+        elif path == "/api/v1/can/stream":
+            self._stream(since, epoch)
+        else:
+            self._send_payload({"status": "error",
+                                "error": {"code": "not_found", "message": path}}, 404)
+
+    def _stream(self, since, epoch):
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Cache-Control", "no-cache")
+        self.send_header("Connection", "close")
+        self.end_headers()
+        self.close_connection = True
+
+        try:
+            # Start with whatever the client is missing (everything if it
+            # has nothing), then push only what changed
+            latest = self.buffer.latest(since, epoch)
+            self._event("latest", latest)
+            self._event("status", self.buffer.status())
+            seq = latest["seq"]
+            epoch = latest["epoch"]
+            last_status = time.time()
+
+            while True:
+                self.buffer.wait_for_change(seq, KEEPALIVE_INTERVAL_S)
+                latest = self.buffer.latest(seq, epoch)
+                if latest["messages"]:
+                    self._event("latest", latest)
+                    seq = latest["seq"]
+                else:
+                    self.wfile.write(b": keepalive\n\n")
+                    self.wfile.flush()
+                if time.time() - last_status >= KEEPALIVE_INTERVAL_S:
+                    self._event("status", self.buffer.status())
+                    last_status = time.time()
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+
+    def _event(self, name, payload):
+        data = json.dumps(payload, separators=(",", ":"))
+        self.wfile.write(f"event: {name}\ndata: {data}\n\n".encode())
+        self.wfile.flush()
+
+
+class LocalHandler(socketserver.BaseRequestHandler):
+    """Length-prefixed frames over a Unix domain socket
+
+    Frame: u32 big-endian length of what follows, u8 kind, u8 format,
+    payload. Kinds: L latest, T status, P snapshot, W watch (subscribe to
+    pushed deltas), K keepalive. Format: C CBOR, J JSON. Requests carry a
+    u64 since-sequence followed by the epoch bytes.
+    """
+
+    buffer = None
+
+    def setup(self):
+        self.write_lock = threading.Lock()
+        self.closed = threading.Event()
+
+    def handle(self):
+        try:
+            while True:
+                header = self._recv_exact(4)
+                if header is None:
+                    break
+                (length,) = struct.unpack(">I", header)
+                body = self._recv_exact(length)
+                if body is None or length < 2:
+                    break
+                kind, fmt, payload = chr(body[0]), chr(body[1]), body[2:]
+                since, epoch = None, None
+                if len(payload) >= 8:
+                    since = struct.unpack(">Q", payload[:8])[0]
+                    epoch = payload[8:].decode(errors="replace")
+                if kind == "L":
+                    self._send("L", fmt, self.buffer.latest(since, epoch))
+                elif kind == "T":
+                    self._send("T", fmt, self.buffer.status())
+                elif kind == "P":
+                    self._send("P", fmt, {"latest": self.buffer.latest(since, epoch),
+                                          "status": self.buffer.status()})
+                elif kind == "W":
+                    threading.Thread(target=self._watch, args=(fmt, since, epoch),
+                                     daemon=True).start()
+        except OSError:
+            pass
+        finally:
+            self.closed.set()
+
+    def _recv_exact(self, count):
+        data = bytearray()
+        while len(data) < count:
+            chunk = self.request.recv(count - len(data))
+            if not chunk:
+                return None
+            data += chunk
+        return bytes(data)
+
+    def _send(self, kind, fmt, payload):
+        if fmt == "C":
+            body = cbor_encode(payload)
+        else:
+            body = json.dumps(payload, separators=(",", ":")).encode()
+        frame = struct.pack(">IBB", len(body) + 2, ord(kind), ord(fmt)) + body
+        with self.write_lock:
+            self.request.sendall(frame)
+
+    def _watch(self, fmt, since, epoch):
+        try:
+            latest = self.buffer.latest(since, epoch)
+            self._send("L", fmt, latest)
+            self._send("T", fmt, self.buffer.status())
+            seq, epoch = latest["seq"], latest["epoch"]
+            last_status = time.time()
+            while not self.closed.is_set():
+                self.buffer.wait_for_change(seq, KEEPALIVE_INTERVAL_S)
+                latest = self.buffer.latest(seq, epoch)
+                if latest["messages"]:
+                    self._send("L", fmt, latest)
+                    seq = latest["seq"]
+                else:
+                    self._send("K", fmt, {})
+                if time.time() - last_status >= KEEPALIVE_INTERVAL_S:
+                    self._send("T", fmt, self.buffer.status())
+                    last_status = time.time()
+        except OSError:
+            pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=5000)
+    parser.add_argument("--rate", type=float, default=100.0,
+                        help="simulated CAN frames per second")
+    parser.add_argument("--unix", metavar="PATH",
+                        help="also serve framed updates on this Unix socket")
+    args = parser.parse_args()
+
+    buffer = CANBuffer()
+    SimulatedBus(buffer, args.rate).start()
+
+    if args.unix:
+        if os.path.exists(args.unix):
+            os.unlink(args.unix)
+        LocalHandler.buffer = buffer
+        local_server = socketserver.ThreadingUnixStreamServer(args.unix, LocalHandler)
+        local_server.daemon_threads = True
+        threading.Thread(target=local_server.serve_forever, daemon=True).start()
+        print(f"EcoCar stand-in server on unix:{args.unix}")
+
+    Handler.buffer = buffer
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.daemon_threads = True
+    print(f"EcoCar stand-in server on http://{args.host}:{args.port}/api/v1")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()